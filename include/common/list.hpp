@@ -0,0 +1,111 @@
+#ifndef COMMON_LIST_HPP
+#define COMMON_LIST_HPP 1
+
+#include <cstddef>
+
+/**
+ * @brief Link embedded in objects that live on an intrusive `List`.
+ *
+ * An object may sit on several lists at once by inheriting one `ListNode` per list, each one
+ * distinguished by a different `Tag` type.
+ */
+template <typename Tag = void>
+struct ListNode {
+  ListNode* prev = nullptr;
+  ListNode* next = nullptr;
+};
+
+/**
+ * @brief Doubly-linked intrusive list that never allocates.
+ *
+ * The list is null-terminated rather than sentinel based so that it can be constant-initialized,
+ * which matters because global constructors are never run by the kernel.
+ */
+template <typename T, typename Tag = void>
+class List {
+ public:
+  using Node = ListNode<Tag>;
+
+  constexpr List() = default;
+
+  bool empty() const { return this->m_head == nullptr; }
+  size_t size() const { return this->m_size; }
+
+  T* front() const { return owner(this->m_head); }
+  T* back() const { return owner(this->m_tail); }
+
+  T* next(T* item) const { return owner(node(item)->next); }
+  T* prev(T* item) const { return owner(node(item)->prev); }
+
+  void push_front(T* item) {
+    Node* entry = node(item);
+
+    entry->prev = nullptr;
+    entry->next = this->m_head;
+
+    if (this->m_head) {
+      this->m_head->prev = entry;
+    } else {
+      this->m_tail = entry;
+    }
+
+    this->m_head = entry;
+    this->m_size++;
+  }
+
+  void push_back(T* item) {
+    Node* entry = node(item);
+
+    entry->next = nullptr;
+    entry->prev = this->m_tail;
+
+    if (this->m_tail) {
+      this->m_tail->next = entry;
+    } else {
+      this->m_head = entry;
+    }
+
+    this->m_tail = entry;
+    this->m_size++;
+  }
+
+  void remove(T* item) {
+    Node* entry = node(item);
+
+    if (entry->prev) {
+      entry->prev->next = entry->next;
+    } else {
+      this->m_head = entry->next;
+    }
+
+    if (entry->next) {
+      entry->next->prev = entry->prev;
+    } else {
+      this->m_tail = entry->prev;
+    }
+
+    entry->prev = nullptr;
+    entry->next = nullptr;
+    this->m_size--;
+  }
+
+  T* pop_front() {
+    T* item = this->front();
+
+    if (item) {
+      this->remove(item);
+    }
+
+    return item;
+  }
+
+ private:
+  static Node* node(T* item) { return static_cast<Node*>(item); }
+  static T* owner(Node* entry) { return entry ? static_cast<T*>(entry) : nullptr; }
+
+  Node* m_head = nullptr;
+  Node* m_tail = nullptr;
+  size_t m_size = 0;
+};
+
+#endif  // COMMON_LIST_HPP
\ No newline at end of file
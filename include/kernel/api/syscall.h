@@ -0,0 +1,40 @@
+/**
+ * @file
+ * @brief This file provides the numbers and the dispatch table of the system calls.
+ *
+ * User mode selects a system call by its number in `%rax` and passes up to six arguments in
+ * `%rdi`, `%rsi`, `%rdx`, `%r10`, `%r8` and `%r9`, the result is returned in `%rax`. The entry
+ * code indexes `syscall_table` with the number, unknown numbers return `-SYSCALL_ENOSYS`.
+ *
+ * The numbers are plain macros, so the header can be included from assembly.
+ */
+#ifndef KERNEL_API_SYSCALL_H
+#define KERNEL_API_SYSCALL_H 1
+
+#define SYSCALL_NULL 0    ///< Returns 0, measures the cost of entering and leaving the kernel.
+#define SYSCALL_EXIT 1    ///< Returns from user mode to the caller of `user_enter`.
+#define SYSCALL_WRITEV 2  ///< Writes an `iovec` array to the output device, see `kernel_writev`.
+#define SYSCALL_COUNT 3   ///< Number of entries in `syscall_table`.
+
+#define SYSCALL_ENOSYS 38  ///< Error number returned, negated, for unknown system calls.
+
+#ifndef __ASSEMBLER__
+
+#include <compiler.h>
+#include <stdint.h>
+
+/// @brief Function implementing a system call, receives the six argument registers.
+typedef int64_t (*SyscallFunction)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+__CDECLS_BEGIN
+
+/**
+ * @brief System call implementations, indexed by their number.
+ */
+extern const SyscallFunction syscall_table[SYSCALL_COUNT];
+
+__CDECLS_END
+
+#endif  // __ASSEMBLER__
+
+#endif  // KERNEL_API_SYSCALL_H
\ No newline at end of file
@@ -25,6 +25,18 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <kernel/arch/x86_64/regs.h>
+#include <kernel/irq/latency.hpp>
+
+/// @brief Size of a cache line in bytes, used to keep independently written data apart.
+#define CACHE_LINE_SIZE 64
+
+/// @brief Maximum number of processors the kernel keeps per-CPU state for.
+#define MAX_CPUS 64
+
+/// @brief Interrupt enable flag in RFLAGS.
+#define ARCH_FLAGS_IF (1ul << 9)
+
 /// @brief Inserts a CPU pause instruction.
 #define arch_pause() WRAP_MACRO(asm volatile("pause"))
 
@@ -37,6 +49,57 @@
 /// @brief Halts the CPU until the next interrupt.
 #define arch_hlt() WRAP_MACRO(asm volatile("hlt"))
 
+/**
+ * @brief Enables interrupts and halts until the next one.
+ * @details `sti` takes effect after the next instruction, so no interrupt can arrive before the
+ * processor halted. Used to sleep after checking for work with interrupts disabled.
+ */
+#define arch_enable_interrupts_and_hlt() WRAP_MACRO(asm volatile("sti; hlt" ::: "memory"))
+
+/**
+ * @brief Disables interrupts and returns the previous interrupt state.
+ * @return Saved RFLAGS, to be passed to `arch_interrupt_restore`.
+ */
+inline uint64_t arch_interrupt_save() {
+  uint64_t flags;
+  asm volatile("pushfq; popq %0; cli" : "=r"(flags)::"memory");
+
+#ifdef ENABLE_IRQ_LATENCY
+  if (flags & ARCH_FLAGS_IF) {
+    uintptr_t ip;
+    asm volatile("leaq 0(%%rip), %0" : "=r"(ip));
+    irqsoff_begin(ip);
+  }
+#endif  // ENABLE_IRQ_LATENCY
+
+  return flags;
+}
+
+/**
+ * @brief Re-enables interrupts if they were enabled when `flags` was saved.
+ * @param flags Value returned by `arch_interrupt_save`.
+ */
+inline void arch_interrupt_restore(uint64_t flags) {
+  if (flags & ARCH_FLAGS_IF) {
+#ifdef ENABLE_IRQ_LATENCY
+    irqsoff_end();
+#endif  // ENABLE_IRQ_LATENCY
+    asm volatile("sti" ::: "memory");
+  }
+}
+
+/**
+ * @brief Returns the index of the executing processor in the range `[0, MAX_CPUS)`.
+ *
+ * @details Reads the index from the per-CPU block the GS base points to. The result is only stable
+ * while the caller cannot migrate, e.g. with interrupts disabled.
+ */
+inline uint32_t arch_cpu_index() {
+  uint32_t index;
+  asm volatile("movl %%gs:%c1, %0" : "=r"(index) : "i"(PERCPU_INDEX_OFFSET));
+  return index;
+}
+
 /// @brief Writes a value to the specified port.
 template <std::unsigned_integral T>
   requires(sizeof(T) <= sizeof(uint32_t))
@@ -87,6 +150,15 @@ __NO_RETURN void arch_halt(bool interrupts = true);
  */
 void arch_initialize();
 
+/**
+ * @brief Enables the boot processor's local APIC and starts all application processors reported by
+ * the bootloader.
+ *
+ * @details Must be called on the boot processor after the kernel heap was initialized. Returns once
+ * every started processor is online or gave up on starting.
+ */
+void arch_smp_initialize();
+
 /**
  * @brief Writes a buffer of characters to the output device.
  * @param buffer Pointer to the character buffer to write.
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief Provides the switch between the kernel stacks of two threads.
+ *
+ * A switch happens inside a function call, so only the registers the System V ABI makes the callee
+ * preserve have to survive it: `context_switch` pushes `%rbp`, `%rbx` and `%r12` to `%r15` on the
+ * outgoing stack, stores the stack pointer, loads the incoming one and pops the same registers
+ * from it. Everything else, including the FPU registers, see `fpu_switch`, and the FS base, is
+ * switched by the caller.
+ *
+ * A new stack starts with a `ContextFrame` whose return address is `context_trampoline`, which
+ * calls the function in `%r13` with the argument in `%r12`.
+ *
+ * Key components:
+ * - `ContextFrame`: Registers saved on the stack of a thread that is not running.
+ * - `context_switch`: Saves the running context and resumes another one.
+ * - `context_trampoline`: First code a new context runs.
+ */
+#ifndef KERNEL_ARCH_CPU_CONTEXT_HPP
+#define KERNEL_ARCH_CPU_CONTEXT_HPP 1
+
+#include <compiler.h>
+
+#include <cstdint>
+
+/**
+ * @brief Registers `context_switch` saves, in stack order from the saved stack pointer upwards.
+ */
+struct ContextFrame {
+  uint64_t r15;
+  uint64_t r14;
+  uint64_t r13;  ///< Function `context_trampoline` calls.
+  uint64_t r12;  ///< Argument `context_trampoline` passes.
+  uint64_t rbx;
+  uint64_t rbp;
+  uint64_t rip;  ///< Return address of `context_switch`.
+};
+
+__CDECLS_BEGIN
+
+/**
+ * @brief Saves the callee-saved registers and the stack pointer to `*save` and resumes the
+ * context whose stack pointer is `load`.
+ * @details Returns once another switch resumes the saved context. Must be called with interrupts
+ * disabled.
+ * @note This function is implemented in assembly.
+ */
+void context_switch(uintptr_t* save, uintptr_t load);
+
+/**
+ * @brief Calls `%r13` with `%r12` as its argument, the function must not return.
+ * @note This function is implemented in assembly and must not be called.
+ */
+void context_trampoline();
+
+__CDECLS_END
+
+#endif  // KERNEL_ARCH_CPU_CONTEXT_HPP
\ No newline at end of file
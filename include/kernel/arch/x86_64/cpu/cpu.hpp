@@ -133,27 +133,91 @@ void fxsave(uint8_t const* region);
 
 /**
  * @brief Saves the processor state to a specified memory region using XSAVE.
- * @param region A pointer to the memory region.
+ * @param region A pointer to the memory region, 64 byte aligned.
+ * @param mask The state components to save, limited to those enabled in XCR0.
  */
-void xsave(uint8_t const* region);
+void xsave(uint8_t const* region, uint64_t mask = RFBM);
 
 /**
  * @brief Saves the processor state to a specified memory region using XSAVEOPT.
- * @param region A pointer to the memory region.
+ * @details Skips components that are in their initial state or were not modified since the last
+ * XRSTOR from the same region.
+ * @param region A pointer to the memory region, 64 byte aligned.
+ * @param mask The state components to save, limited to those enabled in XCR0.
+ */
+void xsaveopt(uint8_t const* region, uint64_t mask = RFBM);
+
+/**
+ * @brief Saves the processor state in the compacted format using XSAVEC.
+ * @details Skips components that are in their initial state.
+ * @param region A pointer to the memory region, 64 byte aligned.
+ * @param mask The state components to save, limited to those enabled in XCR0.
+ */
+void xsavec(uint8_t const* region, uint64_t mask = RFBM);
+
+/**
+ * @brief Saves the processor state in the compacted format using XSAVES.
+ * @details Combines the optimizations of XSAVEC and XSAVEOPT.
+ * @param region A pointer to the memory region, 64 byte aligned.
+ * @param mask The state components to save, limited to those enabled in XCR0 and IA32_XSS.
  */
-void xsaveopt(uint8_t const* region);
+void xsaves(uint8_t const* region, uint64_t mask = RFBM);
 
 /**
  * @brief Restores the processor state from a specified memory region using XRSTOR.
+ * @param region A pointer to the memory region, in the standard or the compacted format.
+ * @param mask The state components to restore, limited to those enabled in XCR0.
+ */
+void xrstor(uint8_t const* region, uint64_t mask = RFBM);
+
+/**
+ * @brief Restores the processor state saved by XSAVES using XRSTORS.
  * @param region A pointer to the memory region.
+ * @param mask The state components to restore, limited to those enabled in XCR0 and IA32_XSS.
  */
-void xrstor(uint8_t const* region);
+void xrstors(uint8_t const* region, uint64_t mask = RFBM);
 
 /**
  * @brief Restores the processor state from a specified memory region using FXRSTOR.
  * @param region A pointer to the memory region.
  */
 void fxrstor(uint8_t const* region);
+
+/**
+ * @brief Reads the extended control register XCR0.
+ */
+uint64_t read_xcr0();
+
+/**
+ * @brief Writes the extended control register XCR0, which selects the XSAVE state components.
+ */
+void write_xcr0(uint64_t value);
+/** @} */
+
+/**
+ * @defgroup monitor_wait Monitor and Wait
+ * @brief Functions to wait for a write to a monitored cache line.
+ * @{
+ */
+/** @brief Arms the address monitor with the cache line containing `addr`. */
+void monitor(const volatile void* addr);
+
+/**
+ * @brief Enables interrupts and waits in the C-state selected by `hint` until the monitored line
+ * is written or an interrupt arrives.
+ * @details `sti` only takes effect once `mwait` executes, so an interrupt that was pending before
+ * ends the wait instead of being missed.
+ */
+void enable_interrupts_and_mwait(uint32_t hint);
+/** @} */
+
+/**
+ * @defgroup timestamp Timestamp Counter
+ * @brief Functions to read the processor's timestamp counter.
+ * @{
+ */
+/** @brief Reads the timestamp counter. */
+uint64_t rdtsc();
 /** @} */
 
 /**
@@ -10,7 +10,6 @@
  *   local APIC interrupts).
  * - The `iframe` structure used to save the CPU register state when an interrupt or exception
  * occurs.
- * - The `nmi_frame` structure used to handle the state during Non-Maskable Interrupts (NMIs).
  * - Macros for setting attributes for interrupt gates, including DPL (Descriptor Privilege Level)
  *   and interrupt type.
  * - Functionality to initialize and load the IDT, which manages the interrupt and exception
@@ -28,6 +27,8 @@
 
 #include <cstdint>
 
+#include <kernel/arch/x86_64/regs.h>
+
 /**
  * @brief Enumeration of Exception Types.
  *
@@ -132,16 +133,6 @@ struct Iframe {
   uint64_t user_ss;   ///< User-space stack segment (if applicable)
 };
 
-/**
- * @brief Frame structure for handling Non-Maskable Interrupt (NMI) contexts.
- *
- * This structure is used for saving the register state during an NMI. In addition
- * to the registers, it also includes a field for the expected GS register value.
- * NMIs are high-priority interrupts that cannot be masked by software.
- */
-struct NmiFrame {
-  Iframe regs;        ///< General register state during the NMI
-  void* expected_gs;  ///< Expected value of the GS register during the NMI
-};
+static_assert(sizeof(Iframe) == IFRAME_SIZE);
 
 #endif  // KERNEL_ARCH_X86_64_CPU_EXCEPTIONS_H
\ No newline at end of file
@@ -26,9 +26,11 @@
 #define CPUID_XSAVE 0xd                   ///< CPUID leaf for XSAVE features.
 #define CPUID_PT 0x14                     ///< CPUID leaf for Processor Trace (PT) features.
 #define CPUID_TSC 0x15                    ///< CPUID leaf for TSC (Time Stamp Counter) information.
+#define CPUID_FREQUENCY 0x16              ///< CPUID leaf for processor frequency information.
 #define CPUID_EXT_BASE 0x80000000         ///< Base value for extended CPUID leafs.
 #define CPUID_FEATS 0x80000001            ///< Extended CPUID leaf for feature flags.
 #define CPUID_BRAND 0x80000002            ///< Extended CPUID leaf for processor brand string.
+#define CPUID_POWER 0x80000007            ///< Extended CPUID leaf for power management features.
 #define CPUID_ADDR_WIDTH 0x80000008       ///< Extended CPUID leaf for address width information.
 #define CPUID_AMD_TOPOLOGY 0x8000001e     ///< Extended CPUID leaf for AMD topology.
 /** @} */
@@ -65,7 +67,7 @@ struct CpuidBit {
  * @param word The register index (EAX, EBX, ECX, or EDX) where the bit resides.
  * @param bit The bit position within the register.
  */
-#define CPUID_BIT(leaf, word, bit) ({leaf, word, bit})
+#define CPUID_BIT(leaf, word, bit) (CpuidBit{leaf, word, bit})
 /** @} */
 
 /**
@@ -116,6 +118,7 @@ struct CpuidBit {
  */
 #define FEATURE_DTS CPUID_BIT(CPUID_THERMAL_AND_POWER, 0, 0)          ///< Digital Thermal Sensor (DTS) support.
 #define FEATURE_TURBO CPUID_BIT(CPUID_THERMAL_AND_POWER, 0, 1)        ///< Turbo Mode support.
+#define FEATURE_ARAT CPUID_BIT(CPUID_THERMAL_AND_POWER, 0, 2)         ///< Local APIC timer runs in deep C-states.
 #define FEATURE_PLN CPUID_BIT(CPUID_THERMAL_AND_POWER, 0, 4)          ///< Power Limit Notification (PLN) support.
 #define FEATURE_PTM CPUID_BIT(CPUID_THERMAL_AND_POWER, 0, 6)          ///< Power Throttle Management (PTM) support.
 #define FEATURE_HWP CPUID_BIT(CPUID_THERMAL_AND_POWER, 0, 7)          ///< Hardware-Controlled Performance States (HWP) support.
@@ -171,6 +174,7 @@ struct CpuidBit {
 #define FEATURE_NX CPUID_BIT(CPUID_FEATS, 3, 20)          ///< No-eXecute bit support.
 #define FEATURE_HUGE_PAGE CPUID_BIT(CPUID_FEATS, 3, 26)   ///< Huge Pages support.
 #define FEATURE_RDTSCP CPUID_BIT(CPUID_FEATS, 3, 27)      ///< RDTSCP instruction support.
+#define FEATURE_INVARIANT_TSC CPUID_BIT(CPUID_POWER, 3, 8) ///< TSC rate is constant in all power states.
 #define FEATURE_INVLPGB CPUID_BIT(CPUID_ADDR_WIDTH, 1, 3) ///< INVLPGB instruction support.
 /** @} */
 
@@ -178,7 +182,7 @@ struct CpuidBit {
 
 /**
  * @defgroup cpuid_xsave_features XSAVE Features
- * @brief Features related to XSAVE instruction set.
+ * @brief Features related to XSAVE instruction set, reported in sub-leaf 1 of `CPUID_XSAVE`.
  * @{
  */
 #define FEATURE_XSAVEOPT CPUID_BIT(CPUID_XSAVE, 0, 0)  ///< XSAVEOPT instruction support.
@@ -0,0 +1,113 @@
+/**
+ * @file
+ * @brief Provides the management of the FPU and SIMD register state of execution contexts.
+ *
+ * The x87, SSE, AVX and AVX-512 registers of an execution context are saved in an `FpuState`
+ * area sized for exactly the components enabled in XCR0. The state is saved with the best
+ * instruction the processor has: XSAVES, which writes the compacted format and skips components
+ * that are in their initial state or were not modified since they were restored; XSAVEC, which
+ * only skips initial components; XSAVEOPT, which skips both in the standard format; then XSAVE
+ * and FXSAVE.
+ *
+ * Restoring is deferred: a context switch only saves the outgoing registers if they were loaded,
+ * and the incoming state is loaded when the processor returns to user mode. Switches between
+ * contexts that stay in the kernel, which does not use the registers, never touch them, and a
+ * context that returns to the processor still holding its registers skips the restore. The
+ * registers are never left to a context that does not own them while it runs in user mode, unlike
+ * a lazy restore from the device-not-available exception.
+ *
+ * The kernel itself is compiled without vector instructions. Code that wants them is compiled in
+ * a SIMD translation unit, see `kernel/meson.build`, and called between `kernel_fpu_begin` and
+ * `kernel_fpu_end`. Beginning a section saves the registers of the running context if they are
+ * loaded and schedules them to be loaded again on the way to user mode, so the section borrows the
+ * registers without a restore of its own.
+ *
+ * Key components:
+ * - `fpu_initialize`: Enables the state components on the executing processor.
+ * - `FpuState` / `fpu_state_init` / `fpu_state_destroy`: The saved state of one context.
+ * - `fpu_switch`: Makes another state the one of the running context.
+ * - `fpu_load`: Loads the state of the running context, called on the way to user mode.
+ * - `kernel_fpu_begin` / `kernel_fpu_end`: Bracket kernel code using vector registers.
+ */
+#ifndef KERNEL_ARCH_CPU_FPU_HPP
+#define KERNEL_ARCH_CPU_FPU_HPP 1
+
+#include <cstddef>
+#include <cstdint>
+
+#define FPU_STATE_ALIGN 64        ///< Alignment XSAVE requires of a save area.
+#define FPU_NO_CPU (~0u)          ///< `FpuState::last_cpu` of a state that was never loaded.
+#define FPU_DEFAULT_FCW 0x037f    ///< x87 control word after `FNINIT`, all exceptions masked.
+#define FPU_DEFAULT_MXCSR 0x1f80  ///< MXCSR at reset, all exceptions masked.
+
+/**
+ * @brief Saved FPU and SIMD registers of one execution context.
+ */
+struct FpuState {
+  uint8_t* area = nullptr;         ///< Save area of `fpu_state_size()` bytes.
+  uint32_t last_cpu = FPU_NO_CPU;  ///< Processor the area was last loaded on.
+};
+
+/**
+ * @brief Enables the FPU, SSE and the XSAVE state components on the executing processor.
+ * @details The first call selects the save instruction and the size of the state for all
+ * processors. Must be called on every processor after its per-CPU block was installed.
+ */
+void fpu_initialize();
+
+/**
+ * @brief Returns the size of the save area of an `FpuState`.
+ */
+size_t fpu_state_size();
+
+/**
+ * @brief Allocates the save area of `state` and fills it with the initial register state.
+ * @details Requires the kernel heap.
+ * @return `false` if the area could not be allocated.
+ */
+bool fpu_state_init(FpuState* state);
+
+/**
+ * @brief Frees the save area of `state`, which must not be the state of any running context.
+ * @details Must be called on the processor the context last ran on.
+ */
+void fpu_state_destroy(FpuState* state);
+
+/**
+ * @brief Makes `next` the state of the context running on the executing processor.
+ *
+ * @details Saves the registers of the previous state if they were loaded. `next` is loaded before
+ * the processor returns to user mode, `nullptr` is for contexts that never do. Called with
+ * interrupts disabled by the context switch, and by `thread_fpu_initialize` to give the running
+ * context its first state.
+ */
+void fpu_switch(FpuState* next);
+
+/**
+ * @brief Loads the state of the running context into the registers.
+ * @details Called by the return paths to user mode, with interrupts disabled, when a load is
+ * pending.
+ */
+extern "C" void fpu_load();
+
+/**
+ * @brief Returns whether the executing processor can enter a kernel FPU section.
+ * @details `false` before `fpu_initialize` and inside a section, e.g. in an interrupt handler that
+ * interrupted one. Code that can run there must fall back to a scalar implementation.
+ */
+bool kernel_fpu_usable();
+
+/**
+ * @brief Starts a section in which the kernel may use the FPU and vector registers.
+ *
+ * @details Sections do not nest and must not switch contexts. MXCSR is reset to its default, the
+ * other registers hold unspecified values. Must only be called if `kernel_fpu_usable` is true.
+ */
+void kernel_fpu_begin();
+
+/**
+ * @brief Ends the section started by `kernel_fpu_begin`.
+ */
+void kernel_fpu_end();
+
+#endif  // KERNEL_ARCH_CPU_FPU_HPP
\ No newline at end of file
@@ -33,6 +33,22 @@
 /** @brief Maximum number of entries in the Global Descriptor Table. */
 #define MAX_GDT_ENTRIES 5
 
+/** @brief Number of dedicated interrupt stacks per processor. */
+#define INTERRUPT_STACK_COUNT 4
+
+/**
+ * @brief Interrupt Stack Table slots used by the kernel.
+ * @details Exceptions that can hit while the current stack is unusable, or that can nest into
+ * another handler, switch to a dedicated stack of the executing processor.
+ */
+enum InterruptStack : uint8_t {
+  IST_NONE = 0,           ///< Stay on the current stack.
+  IST_NMI = 1,            ///< Non-maskable interrupts.
+  IST_DOUBLE_FAULT = 2,   ///< Double faults, e.g. after a kernel stack overflow.
+  IST_MACHINE_CHECK = 3,  ///< Machine check exceptions.
+  IST_DEBUG = 4,          ///< Debug exceptions.
+};
+
 /**
  * @struct
  * @brief Task State Segment (TSS) structure for x86_64.
@@ -100,12 +116,26 @@ struct GdtTable {
   TssSegment tss_segment;
 };
 
+/**
+ * @brief Descriptor table and TSS of a single processor.
+ */
 class Gdt {
  public:
   Gdt() = default;
   void initialize();
+
   void load();
 
+  /**
+   * @brief Makes `stack_top` the stack the processor switches to for gates using `ist`.
+   */
+  void set_interrupt_stack(InterruptStack ist, uintptr_t stack_top);
+
+  /**
+   * @brief Makes `stack_top` the stack the processor switches to on interrupts from user mode.
+   */
+  void set_kernel_stack(uintptr_t stack_top);
+
  private:
   GdtTable m_table = {};
   Tss m_tss = {};
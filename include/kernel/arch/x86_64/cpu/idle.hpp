@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Provides the idle loop's wait for work and the wakeup of idle processors.
+ *
+ * An idle processor waits with `mwait` on `PerCpu::idle_flags`, which sits on a cache line of its
+ * own. While it waits, the flags hold `IDLE_POLLING`, and waking it only takes setting
+ * `IDLE_WAKE`: the write itself ends the wait, so no IPI is sent and no interrupt handler runs on
+ * the woken processor. Processors that halt with `hlt` instead, because `mwait` is not supported,
+ * announce `IDLE_HALTED` and are woken with `INTERRUPT_IPI_RESCHEDULE`. Busy processors are not
+ * interrupted at all, they check for work before they wait again.
+ *
+ * `mwait` takes a hint for the C-state to enter, chosen from those CPUID leaf 5 enumerates. Deeper
+ * states save more power but take longer to leave, so a state is only used if the expected idle
+ * time, the earlier of the next timer and the average of the recent idle periods, reaches its
+ * target residency.
+ *
+ * Key components:
+ * - `idle_initialize`: Selects the wait instruction and registers the wakeup IPI.
+ * - `idle_enter`: Waits until work arrives, called by the idle loop.
+ * - `idle_wake`: Wakes another processor after queueing work for it.
+ */
+#ifndef KERNEL_ARCH_CPU_IDLE_HPP
+#define KERNEL_ARCH_CPU_IDLE_HPP 1
+
+#include <cstdint>
+
+/**
+ * @defgroup idle_flags Idle Flags
+ * @brief Bits of `PerCpu::idle_flags`.
+ * @{
+ */
+#define IDLE_POLLING (1u << 0)  ///< Waits in `mwait`, a write to the flags wakes it.
+#define IDLE_HALTED (1u << 1)   ///< Waits in `hlt`, only an interrupt wakes it.
+#define IDLE_WAKE (1u << 2)     ///< Set by `idle_wake`, the waiting processor has work.
+/** @} */
+
+#define IDLE_MAX_STATES 8        ///< C-states CPUID leaf 5 can enumerate, C0 to C7.
+#define IDLE_PREDICTION_SHIFT 3  ///< Weight of the last idle period in the average, `2^-n`.
+
+/**
+ * @brief Selects `mwait` or `hlt` and the C-states, and registers the handler of the wakeup IPI.
+ * @details Must be called once, on the boot processor, after the clock was initialized.
+ */
+void idle_initialize();
+
+/**
+ * @brief Waits until an interrupt arrives or another processor calls `idle_wake`.
+ *
+ * @details Must be called with interrupts disabled and returns with interrupts enabled.
+ * `work_pending` is called after the processor announced that it waits, and the wait is skipped if
+ * it returns `true`, so work queued concurrently is either seen or wakes the processor.
+ */
+void idle_enter(bool (*work_pending)());
+
+/**
+ * @brief Makes the processor with index `cpu` leave `idle_enter`.
+ * @details Called after the work for it was published. Sends an IPI only if the processor halted.
+ */
+void idle_wake(uint32_t cpu);
+
+#endif  // KERNEL_ARCH_CPU_IDLE_HPP
\ No newline at end of file
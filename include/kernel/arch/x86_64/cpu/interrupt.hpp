@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @brief Provides the registry of interrupt handlers and per-vector statistics.
+ *
+ * The common interrupt entry looks up the handler of a vector in a table and calls it directly,
+ * so an interrupt reaches its handler without passing through any C++ dispatch code. Vectors
+ * without a handler go to `exception_handler`, which reports the fault and panics.
+ *
+ * Software interrupts raised by a handler run when it returns, see `softirq_raise`.
+ *
+ * Every processor counts the interrupts it handled per vector and the TSC cycles spent in their
+ * handlers. The counters live in the processor's `PerCpu` block and are updated by the entry code
+ * with `%gs` relative instructions.
+ *
+ * Key components:
+ * - `interrupt_register` / `interrupt_unregister`: Attach a handler to a fixed vector.
+ * - `interrupt_allocate`: Attach a handler to a free vector in the dynamic range.
+ * - `interrupt_stats` / `interrupt_dump`: Read the statistics of all processors.
+ *
+ * @note Handlers run with interrupts disabled and must signal the end of interrupt themselves,
+ * e.g. with `lapic_eoi`.
+ */
+#ifndef KERNEL_ARCH_CPU_INTERRUPT_HPP
+#define KERNEL_ARCH_CPU_INTERRUPT_HPP 1
+
+#include <cstdint>
+
+#include <kernel/arch/x86_64/cpu/exceptions.hpp>
+#include <kernel/arch/x86_64/regs.h>
+
+#define INTERRUPT_DYNAMIC_BASE (IRQ_SECONDARY_ATA + 1)   ///< Start of the dynamic vector range.
+#define INTERRUPT_DYNAMIC_END INTERRUPT_LOCAL_APIC_BASE  ///< End of the dynamic vector range.
+
+/// @brief Function handling an interrupt, `data` is the pointer passed at registration.
+using InterruptHandler = void (*)(Iframe* iframe, void* data);
+
+/**
+ * @brief Interrupts handled on one processor for one vector.
+ */
+struct InterruptStats {
+  uint64_t count;   ///< Number of handled interrupts.
+  uint64_t cycles;  ///< TSC cycles spent in the handler.
+};
+
+static_assert(sizeof(InterruptStats) == 1u << INTERRUPT_STATS_SHIFT);
+
+/**
+ * @brief Attaches `handler` to `vector`.
+ * @return `false` if the vector already has a handler or is the NMI vector.
+ */
+bool interrupt_register(uint8_t vector, InterruptHandler handler, void* data = nullptr);
+
+/**
+ * @brief Attaches `handler` to a free vector in `[INTERRUPT_DYNAMIC_BASE, INTERRUPT_DYNAMIC_END)`.
+ * @return The vector, or 0 if all are taken.
+ */
+uint8_t interrupt_allocate(InterruptHandler handler, void* data = nullptr);
+
+/**
+ * @brief Detaches the handler of `vector`.
+ * @details The caller must make sure the vector is no longer raised, a handler that already
+ * started keeps running.
+ */
+void interrupt_unregister(uint8_t vector);
+
+/// @brief Returns the statistics of `vector` summed over all processors.
+InterruptStats interrupt_stats(uint8_t vector);
+
+/// @brief Logs the statistics of every vector that was raised at least once.
+void interrupt_dump();
+
+/**
+ * @brief Runs the software interrupts raised by the handler of the interrupt described by `iframe`.
+ * @details Called by the entry code after the handler returned, with interrupts disabled.
+ */
+extern "C" void interrupt_exit(Iframe* iframe);
+
+#endif  // KERNEL_ARCH_CPU_INTERRUPT_HPP
\ No newline at end of file
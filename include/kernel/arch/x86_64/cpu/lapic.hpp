@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Provides the local APIC driver and inter-processor interrupts.
+ *
+ * Every processor has a local APIC that delivers interrupts to it and sends interrupts to other
+ * processors. The driver prefers x2APIC mode, where the registers are MSRs and an IPI is a single
+ * write of the 64 bit interrupt command register. Without x2APIC support it falls back to xAPIC
+ * mode, where the registers are memory mapped and an IPI takes two writes plus a wait for the
+ * previous one to be delivered.
+ *
+ * Key components:
+ * - `lapic_initialize`: Enables the local APIC of the executing processor.
+ * - `lapic_eoi`: Signals the end of an interrupt.
+ * - `lapic_send_ipi` / `lapic_send_ipi_self` / `lapic_send_ipi_others` / `lapic_send_ipi_mask`:
+ *   Send an interrupt to one processor, to the executing one, to all others or to a set.
+ * - `lapic_timer_arm` / `lapic_timer_disarm`: Program the one-shot timer with a TSC deadline.
+ *
+ * The timer uses TSC-deadline mode where available, so a deadline is a single MSR write with TSC
+ * resolution. Otherwise the one-shot count-down mode is used, with the ratio of timer ticks to TSC
+ * cycles calibrated once at boot.
+ *
+ * Processors are addressed by their index, see `cpu_data`.
+ */
+#ifndef KERNEL_ARCH_CPU_LAPIC_HPP
+#define KERNEL_ARCH_CPU_LAPIC_HPP 1
+
+#include <cstdint>
+
+/**
+ * @defgroup lapic_registers Local APIC Registers
+ * @brief Offsets in the xAPIC page, the x2APIC MSR of a register is `0x800 + (offset >> 4)`.
+ * @{
+ */
+#define LAPIC_REG_ID 0x020             ///< Local APIC ID.
+#define LAPIC_REG_VERSION 0x030        ///< Version and number of LVT entries.
+#define LAPIC_REG_TPR 0x080            ///< Task priority.
+#define LAPIC_REG_EOI 0x0b0            ///< End of interrupt.
+#define LAPIC_REG_LDR 0x0d0            ///< Logical destination.
+#define LAPIC_REG_SIVR 0x0f0           ///< Spurious interrupt vector.
+#define LAPIC_REG_ESR 0x280            ///< Error status.
+#define LAPIC_REG_ICR_LOW 0x300        ///< Interrupt command, bits 0-31.
+#define LAPIC_REG_ICR_HIGH 0x310       ///< Interrupt command, bits 32-63 (xAPIC only).
+#define LAPIC_REG_LVT_TIMER 0x320      ///< Timer local vector.
+#define LAPIC_REG_LVT_ERROR 0x370      ///< Error local vector.
+#define LAPIC_REG_TIMER_INIT 0x380     ///< Initial count of the timer.
+#define LAPIC_REG_TIMER_CURRENT 0x390  ///< Current count of the timer.
+#define LAPIC_REG_TIMER_DIVIDE 0x3e0   ///< Divider of the timer input clock.
+#define LAPIC_REG_SELF_IPI 0x3f0       ///< Self IPI (x2APIC only).
+/** @} */
+
+#define LAPIC_MMIO_SIZE 0x1000  ///< Size of the xAPIC register page.
+
+/**
+ * @defgroup apic_base_flags IA32_APIC_BASE Flags
+ * @{
+ */
+#define APIC_BASE_BSP (1ul << 8)                     ///< Set on the boot processor.
+#define APIC_BASE_X2APIC (1ul << 10)                 ///< Enables x2APIC mode.
+#define APIC_BASE_ENABLE (1ul << 11)                 ///< Enables the local APIC.
+#define APIC_BASE_ADDRESS_MASK 0x000ffffffffff000ul  ///< Physical address of the xAPIC page.
+/** @} */
+
+#define LAPIC_SIVR_ENABLE (1u << 8)  ///< Software enable bit of the spurious interrupt register.
+#define LAPIC_LVT_MASKED (1u << 16)  ///< Masks a local vector table entry.
+
+#define LAPIC_TIMER_ONE_SHOT (0u << 17)      ///< Timer mode: count down once.
+#define LAPIC_TIMER_TSC_DEADLINE (2u << 17)  ///< Timer mode: fire when the TSC passes a deadline.
+#define LAPIC_TIMER_DIVIDE_16 0x3u           ///< Divide configuration for a divider of 16.
+
+/// @brief TSC cycles the one-shot timer is calibrated over.
+#define LAPIC_TIMER_CALIBRATION_CYCLES (1ul << 24)
+
+/**
+ * @defgroup lapic_icr_flags Interrupt Command Register Flags
+ * @{
+ */
+#define LAPIC_ICR_LOGICAL (1u << 11)  ///< The destination is a logical ID.
+#define LAPIC_ICR_PENDING (1u << 12)  ///< The previous IPI was not yet accepted (xAPIC only).
+#define LAPIC_ICR_ASSERT (1u << 14)   ///< Level assert, required for fixed IPIs.
+#define LAPIC_ICR_SELF (1u << 18)     ///< Destination shorthand: the sender.
+#define LAPIC_ICR_ALL (2u << 18)      ///< Destination shorthand: all processors.
+#define LAPIC_ICR_OTHERS (3u << 18)   ///< Destination shorthand: all but the sender.
+/** @} */
+
+/**
+ * @brief Enables the local APIC of the executing processor and records its IDs.
+ *
+ * @details The first call selects the mode for all processors and must happen on the boot
+ * processor before the others start. In xAPIC mode it maps the register page, which requires the
+ * physical allocator.
+ */
+void lapic_initialize();
+
+/// @brief Returns whether the local APICs run in x2APIC mode.
+bool lapic_x2apic();
+
+/// @brief Returns the local APIC ID of the executing processor.
+uint32_t lapic_id();
+
+/// @brief Signals the end of the interrupt being handled, except for spurious interrupts.
+void lapic_eoi();
+
+/// @brief Reports and clears the errors latched in the error status register.
+void lapic_handle_error();
+
+/// @brief Sends `vector` to the processor with index `cpu`.
+void lapic_send_ipi(uint32_t cpu, uint8_t vector);
+
+/// @brief Sends `vector` to the executing processor.
+void lapic_send_ipi_self(uint8_t vector);
+
+/// @brief Sends `vector` to all processors except the executing one.
+void lapic_send_ipi_others(uint8_t vector);
+
+/**
+ * @brief Programs the timer of the executing processor to fire `INTERRUPT_APIC_TIMER` once the TSC
+ * reaches `deadline`.
+ * @details Deadlines in the past fire right away.
+ */
+void lapic_timer_arm(uint64_t deadline);
+
+/// @brief Cancels the pending timer interrupt of the executing processor.
+void lapic_timer_disarm();
+
+/**
+ * @brief Sends `vector` to every processor whose index is set in `cpus`.
+ * @details In x2APIC mode, processors in the same logical cluster share a single IPI.
+ */
+void lapic_send_ipi_mask(uint64_t cpus, uint8_t vector);
+
+#endif  // KERNEL_ARCH_CPU_LAPIC_HPP
\ No newline at end of file
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Provides mappings of device memory into the higher half direct map and of user pages.
+ *
+ * Limine only maps memory map entries into the higher half direct map, so memory mapped device
+ * registers such as the local APIC are not accessible after boot. `map_mmio` adds uncached 4 KiB
+ * mappings for such registers to the page tables loaded by Limine, which all processors share, at
+ * the same offset the direct map uses for RAM. Firmware tables outside the direct map are added
+ * the same way with `map_firmware`, cached and read-only. Kernel stacks are mapped page by page
+ * with `map_kernel_page` into a region of their own, where unmapped guard pages separate them.
+ * User pages are mapped into the lower half of the same tables, with `PTE_USER` set on every level
+ * that leads to them.
+ *
+ * Key components:
+ * - `map_mmio`: Maps a physical register range and returns its virtual address.
+ * - `map_firmware`: Maps a physical range of firmware tables and returns its virtual address.
+ * - `map_kernel_page`: Maps a page of RAM to a chosen higher half address.
+ * - `map_user_page`: Maps a page of RAM that user mode can access into the lower half.
+ */
+#ifndef KERNEL_ARCH_CPU_PAGING_HPP
+#define KERNEL_ARCH_CPU_PAGING_HPP 1
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @defgroup page_table_flags Page Table Entry Flags
+ * @{
+ */
+#define PTE_PRESENT (1ul << 0)                 ///< The entry is valid.
+#define PTE_WRITABLE (1ul << 1)                ///< Writes are allowed.
+#define PTE_USER (1ul << 2)                    ///< User mode accesses are allowed.
+#define PTE_WRITE_THROUGH (1ul << 3)           ///< PAT index bit 0.
+#define PTE_CACHE_DISABLE (1ul << 4)           ///< PAT index bit 1.
+#define PTE_HUGE (1ul << 7)                    ///< The entry maps a 2 MiB or 1 GiB page.
+#define PTE_NO_EXECUTE (1ul << 63)             ///< Instruction fetches are not allowed.
+#define PTE_ADDRESS_MASK 0x000ffffffffff000ul  ///< Physical address of the page or table.
+/** @} */
+
+#define PAGE_TABLE_ENTRIES 512  ///< Entries per page table at every level.
+
+/**
+ * @brief Maps device registers uncached into the higher half direct map.
+ *
+ * @param phys Physical address of the registers, need not be page aligned.
+ * @param size Size of the register range in bytes.
+ * @return Virtual address of `phys`.
+ *
+ * @note Requires the physical allocator, page tables are allocated from it.
+ */
+void* map_mmio(uintptr_t phys, size_t size);
+
+/**
+ * @brief Maps firmware tables, e.g. of ACPI, cached and read-only into the higher half direct map.
+ *
+ * @param phys Physical address of the tables, need not be page aligned.
+ * @param size Size of the range in bytes.
+ * @return Virtual address of `phys`.
+ *
+ * @note Requires the physical allocator, page tables are allocated from it.
+ */
+const void* map_firmware(uintptr_t phys, size_t size);
+
+/**
+ * @brief Maps the 4 KiB page at `phys` to the higher half address `virt` for the kernel only.
+ *
+ * @param flags Additional flags of the mapping, e.g. `PTE_WRITABLE` or `PTE_NO_EXECUTE`.
+ * @return `false` if `virt` is not a page aligned higher half address or is already mapped.
+ *
+ * @note Requires the physical allocator, page tables are allocated from it.
+ */
+bool map_kernel_page(uintptr_t virt, uintptr_t phys, uint64_t flags);
+
+/**
+ * @brief Maps the 4 KiB page at `phys` to the lower half address `virt` for user mode.
+ *
+ * @param flags Additional flags of the mapping, e.g. `PTE_WRITABLE` or `PTE_NO_EXECUTE`.
+ * @return `false` if `virt` is not a page aligned lower half address or is already mapped.
+ *
+ * @note Requires the physical allocator, page tables are allocated from it.
+ */
+bool map_user_page(uintptr_t virt, uintptr_t phys, uint64_t flags);
+
+#endif  // KERNEL_ARCH_CPU_PAGING_HPP
\ No newline at end of file
@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Provides the per-CPU data block and accessors for the executing processor.
+ *
+ * Every processor owns one cache line aligned `PerCpu` block. While running in the kernel, the GS
+ * base of a processor points at its own block, so the fields of the executing processor can be
+ * read with a single `%gs` relative load, without knowing its index and without a lookup table.
+ * The first field of every block points at the block itself, which turns the GS base into a normal
+ * pointer.
+ *
+ * Key components:
+ * - `PerCpu`: State owned by one processor.
+ * - `this_cpu`: Returns the block of the executing processor.
+ * - `this_cpu_read` / `this_cpu_write`: Access a single field of the executing processor's block.
+ * - `cpu_data` / `cpu_count`: Access the blocks of other processors.
+ *
+ * @note The accessors are only meaningful while the caller cannot migrate to another processor,
+ * e.g. with interrupts disabled.
+ */
+#ifndef KERNEL_ARCH_CPU_PERCPU_HPP
+#define KERNEL_ARCH_CPU_PERCPU_HPP 1
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel/arch/x86_64/arch.hpp>
+#include <kernel/arch/x86_64/cpu/fpu.hpp>
+#include <kernel/arch/x86_64/cpu/gdt.hpp>
+#include <kernel/arch/x86_64/cpu/idt.hpp>
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+#include <kernel/arch/x86_64/regs.h>
+
+/// @brief Function run on another processor through `smp_call`.
+using SmpFunction = void (*)(void* arg);
+
+/**
+ * @brief State owned by a single processor.
+ *
+ * @details `self`, `index`, `interrupt_stats`, `softirq_pending`, the system call stacks and
+ * `fpu_load_pending` are read from assembly and by `arch_cpu_index`, their offsets are fixed in
+ * `regs.h`. New fields go after `fpu_load_pending`.
+ */
+struct alignas(CACHE_LINE_SIZE) PerCpu {
+  PerCpu* self;           ///< Address of this block.
+  uint32_t index;         ///< Index of the processor in `[0, cpu_count())`.
+  uint32_t lapic_id;      ///< Local APIC ID of the processor.
+  uint32_t processor_id;  ///< ACPI processor UID of the processor.
+  uint32_t lapic_ldr;     ///< x2APIC logical ID, 0 in xAPIC mode.
+
+  std::atomic<bool> online;  ///< Set once the processor finished its initialization.
+
+  std::atomic<SmpFunction> call_function;  ///< Pending cross call, `nullptr` when idle.
+  void* call_arg;                          ///< Argument of the pending cross call.
+
+  uint32_t irq_depth;  ///< Nesting depth of `irq_disable`.
+  uint64_t irq_flags;  ///< RFLAGS saved by the outermost `irq_disable`.
+
+  /// @brief Interrupts handled per vector, updated by the interrupt entry code.
+  alignas(CACHE_LINE_SIZE) InterruptStats interrupt_stats[MAX_IDT_ENTRIES];
+
+  uint32_t softirq_pending;  ///< Raised software interrupts, one bit per `SoftirqType`.
+  uint32_t softirq_depth;    ///< Nesting depth of `softirq_disable`, 1 while handlers run.
+
+  uintptr_t kernel_stack;  ///< Top of the stack system calls run on.
+  uintptr_t user_stack;    ///< User stack pointer of the running system call.
+  uintptr_t user_return;   ///< Kernel stack pointer of the running `user_enter`.
+
+  uint32_t fpu_load_pending;   ///< Set if `fpu_current` must be loaded before user mode runs.
+  FpuState* fpu_current;       ///< FPU state of the running context.
+  FpuState* fpu_owner;         ///< State the FPU registers were last loaded from or saved to.
+  uint32_t fpu_kernel_usable;  ///< Set once the FPU is enabled, cleared in a kernel FPU section.
+
+  uint64_t idle_predicted_ns;  ///< Average length of the recent idle periods.
+
+  /// @brief `IDLE_*` state, monitored by `mwait`, on a cache line of its own so only wakeups
+  /// write it.
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> idle_flags;
+
+  alignas(CACHE_LINE_SIZE) Gdt gdt;  ///< Descriptor table and TSS of the processor.
+
+  /// @brief Stacks used by the gates in `InterruptStack`, slot `n` uses `interrupt_stacks[n - 1]`.
+  alignas(16) uint8_t interrupt_stacks[INTERRUPT_STACK_COUNT][INTERRUPT_STACK_SIZE];
+
+  /// @brief Stack of system calls and interrupts from user mode, `kernel_stack` is its top.
+  alignas(16) uint8_t syscall_stack[KERNEL_STACK_SIZE];
+};
+
+static_assert(offsetof(PerCpu, self) == PERCPU_SELF_OFFSET);
+static_assert(offsetof(PerCpu, index) == PERCPU_INDEX_OFFSET);
+static_assert(offsetof(PerCpu, interrupt_stats) == PERCPU_INTERRUPT_STATS_OFFSET);
+static_assert(offsetof(PerCpu, softirq_pending) == PERCPU_SOFTIRQ_PENDING_OFFSET);
+static_assert(offsetof(PerCpu, kernel_stack) == PERCPU_KERNEL_STACK_OFFSET);
+static_assert(offsetof(PerCpu, user_stack) == PERCPU_USER_STACK_OFFSET);
+static_assert(offsetof(PerCpu, user_return) == PERCPU_USER_RETURN_OFFSET);
+static_assert(offsetof(PerCpu, fpu_load_pending) == PERCPU_FPU_LOAD_OFFSET);
+
+/**
+ * @brief Returns the per-CPU block of the executing processor.
+ */
+inline PerCpu* this_cpu() {
+  PerCpu* cpu;
+  asm volatile("movq %%gs:%c1, %0" : "=r"(cpu) : "i"(PERCPU_SELF_OFFSET));
+  return cpu;
+}
+
+/**
+ * @brief Reads the field at `Offset` of the executing processor's block with one `%gs` load.
+ */
+template <typename T, size_t Offset>
+  requires(sizeof(T) == 4 || sizeof(T) == 8)
+T percpu_read() {
+  T value;
+
+  if constexpr (sizeof(T) == 4) {
+    asm volatile("movl %%gs:%c1, %0" : "=r"(value) : "i"(Offset));
+  } else {
+    asm volatile("movq %%gs:%c1, %0" : "=r"(value) : "i"(Offset));
+  }
+
+  return value;
+}
+
+/**
+ * @brief Writes the field at `Offset` of the executing processor's block with one `%gs` store.
+ */
+template <typename T, size_t Offset>
+  requires(sizeof(T) == 4 || sizeof(T) == 8)
+void percpu_write(T value) {
+  if constexpr (sizeof(T) == 4) {
+    asm volatile("movl %0, %%gs:%c1" ::"r"(value), "i"(Offset) : "memory");
+  } else {
+    asm volatile("movq %0, %%gs:%c1" ::"r"(value), "i"(Offset) : "memory");
+  }
+}
+
+/// @brief Reads `field` of the executing processor's `PerCpu` block.
+#define this_cpu_read(field) percpu_read<decltype(PerCpu::field), offsetof(PerCpu, field)>()
+
+/// @brief Writes `value` to `field` of the executing processor's `PerCpu` block.
+#define this_cpu_write(field, value) \
+  percpu_write<decltype(PerCpu::field), offsetof(PerCpu, field)>(value)
+
+/**
+ * @brief Returns the per-CPU block of the processor with the given index.
+ */
+PerCpu* cpu_data(uint32_t index);
+
+/**
+ * @brief Returns the number of processors the kernel manages.
+ */
+uint32_t cpu_count();
+
+/**
+ * @brief Makes `cpu` the per-CPU block of the executing processor.
+ *
+ * @details Points the GS base at the block and clears the kernel GS base, which `swapgs` exchanges
+ * with the GS base on entry from and exit to user mode. Must be called after the GDT was loaded,
+ * since reloading `%gs` clears the GS base.
+ */
+void percpu_install(PerCpu* cpu);
+
+#endif  // KERNEL_ARCH_CPU_PERCPU_HPP
\ No newline at end of file
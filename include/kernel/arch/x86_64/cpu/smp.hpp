@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Provides the bring-up of application processors and cross calls between processors.
+ *
+ * The boot processor asks Limine to start all other processors. Each application processor loads
+ * the kernel's descriptor tables, installs its per-CPU block, enables its local APIC and then
+ * halts in `smp_idle`. `smp_call` posts work to a processor's mailbox and wakes it with an IPI.
+ *
+ * Cross calls may be issued concurrently from any processor, they are serialized by one lock. The
+ * caller waits with interrupts disabled and runs calls posted to itself while it waits for the
+ * lock, so two callers cannot wait for each other. A call must not issue a cross call itself, and
+ * the target of a call must not spin with interrupts disabled on something the caller holds.
+ *
+ * Key components:
+ * - `arch_initialize_ap`: Per processor counterpart of `arch_initialize`.
+ * - `smp_call` / `smp_call_all`: Run a function on one or on all online processors.
+ */
+#ifndef KERNEL_ARCH_CPU_SMP_HPP
+#define KERNEL_ARCH_CPU_SMP_HPP 1
+
+#include <compiler.h>
+
+#include <cstdint>
+
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+
+/// @brief Iterations to wait for an application processor before giving up on it.
+#define SMP_STARTUP_SPIN_LIMIT (1ul << 28)
+
+/**
+ * @brief Initializes the executing application processor with its per-CPU block.
+ */
+void arch_initialize_ap(PerCpu* cpu);
+
+/**
+ * @brief Halts the executing processor, forever, running cross calls from their IPI.
+ */
+__NO_RETURN void smp_idle();
+
+/**
+ * @brief Runs the cross call posted to the executing processor, if any.
+ * @details Called from the `INTERRUPT_IPI_GENERIC` handler, which `arch_smp_initialize` registers.
+ */
+void smp_handle_call();
+
+/**
+ * @brief Runs `function(arg)` on the processor with index `cpu` and waits for it to return.
+ *
+ * @return False if the processor does not exist or is not online.
+ */
+bool smp_call(uint32_t cpu, SmpFunction function, void* arg);
+
+/**
+ * @brief Runs `function(arg)` on every online processor, including the caller, and waits until all
+ * of them returned.
+ */
+void smp_call_all(SmpFunction function, void* arg);
+
+#endif  // KERNEL_ARCH_CPU_SMP_HPP
\ No newline at end of file
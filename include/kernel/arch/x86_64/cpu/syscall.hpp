@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief Provides the `syscall` / `sysretq` fast system call entry and the transition to user mode.
+ *
+ * `syscall` enters the kernel without a gate lookup or a stack switch through the TSS: the
+ * processor loads the kernel code segment and `syscall_entry` from MSRs and masks the flags in
+ * `MSR_FMASK`. The entry code exchanges the GS base with `swapgs`, saves the user stack pointer in
+ * the per-CPU block and switches to the processor's kernel stack, then calls the function of the
+ * system call from `syscall_table` with interrupts enabled. `sysretq` returns to user mode; a
+ * non-canonical return address, which `sysretq` would fault on in kernel mode, returns through
+ * `iretq` instead.
+ *
+ * Key components:
+ * - `syscall_initialize`: Enables `syscall` and programs the entry MSRs of the executing processor.
+ * - `user_enter` / `user_exit`: Run code in user mode until it exits with `SYSCALL_EXIT`.
+ * - `syscall_benchmark_run`: Measures the round trip of `SYSCALL_NULL` from user mode, when the
+ *   kernel is configured with `-Denable-benchmarks=true`.
+ */
+#ifndef KERNEL_ARCH_CPU_SYSCALL_HPP
+#define KERNEL_ARCH_CPU_SYSCALL_HPP 1
+
+#include <compiler.h>
+
+#include <cstdint>
+
+#define SYSCALL_BENCHMARK_ITERATIONS 100000  ///< System calls per benchmark run.
+
+/**
+ * @brief Enables `syscall` on the executing processor and points it at `syscall_entry`.
+ * @details Must be called after the per-CPU block was installed.
+ */
+void syscall_initialize();
+
+__CDECLS_BEGIN
+
+/**
+ * @brief Entry point of `syscall`, loaded into `MSR_LSTAR`.
+ * @note This function is implemented in assembly and must not be called.
+ */
+void syscall_entry();
+
+/**
+ * @brief Runs `entry` in user mode on `stack` with `arg` in `%rdi`.
+ * @details Returns once the code calls `SYSCALL_EXIT`, with interrupts in the state they were
+ * in before. `entry` and `stack` must be mapped with `PTE_USER`, and the running thread must have
+ * an FPU state, see `thread_fpu_initialize`. Calls do not nest.
+ * @return The argument passed to `SYSCALL_EXIT`.
+ * @note This function is implemented in assembly.
+ */
+int64_t user_enter(uintptr_t entry, uintptr_t stack, uint64_t arg);
+
+/**
+ * @brief Abandons the running system call and returns `value` from `user_enter`.
+ * @note This function is implemented in assembly.
+ */
+__NO_RETURN void user_exit(int64_t value);
+
+__CDECLS_END
+
+#ifdef ENABLE_BENCHMARKS
+
+/**
+ * @brief Measures the cost of a `SYSCALL_NULL` round trip from user mode and logs it.
+ * @details Checks first that user registers survive a kernel FPU section. Must be called after the
+ * physical memory allocator and the kernel heap were initialized.
+ */
+void syscall_benchmark_run();
+
+#else
+
+inline void syscall_benchmark_run() {}
+
+#endif  // ENABLE_BENCHMARKS
+
+#endif  // KERNEL_ARCH_CPU_SYSCALL_HPP
\ No newline at end of file
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief Provides the lookup of ACPI tables and the layout of the Multiple APIC Description Table.
+ *
+ * Limine passes the physical address of the RSDP, which points to the XSDT, or to the RSDT on
+ * ACPI 1.0 firmware. Both list the physical addresses of all other tables. Tables are mapped into
+ * the higher half direct map when they are looked up and only returned if their checksum is valid.
+ *
+ * Key components:
+ * - `AcpiHeader`: Header common to all system description tables.
+ * - `acpi_find_table`: Returns the table with a given signature.
+ * - `Madt` and its entries: Interrupt controllers and interrupt source overrides.
+ */
+#ifndef KERNEL_DRIVERS_ACPI_HPP
+#define KERNEL_DRIVERS_ACPI_HPP 1
+
+#include <compiler.h>
+
+#include <cstdint>
+
+#define ACPI_SIGNATURE_MADT "APIC"  ///< Signature of the Multiple APIC Description Table.
+
+/**
+ * @brief Header of every system description table.
+ */
+struct AcpiHeader {
+  char signature[4];          ///< Table signature, not terminated.
+  uint32_t length;            ///< Size of the table including the header.
+  uint8_t revision;           ///< Revision of the table layout.
+  uint8_t checksum;           ///< Makes the bytes of the table sum to 0.
+  char oem_id[6];             ///< OEM identifier.
+  char oem_table_id[8];       ///< OEM table identifier.
+  uint32_t oem_revision;      ///< OEM revision of the table.
+  uint32_t creator_id;        ///< Vendor of the tool that created the table.
+  uint32_t creator_revision;  ///< Revision of that tool.
+} __PACKED;
+
+/**
+ * @defgroup madt_entries MADT Entry Types
+ * @{
+ */
+#define MADT_LOCAL_APIC 0           ///< Processor local APIC.
+#define MADT_IOAPIC 1               ///< I/O APIC.
+#define MADT_SOURCE_OVERRIDE 2      ///< Interrupt source override of an ISA IRQ.
+#define MADT_PCAT_COMPAT (1u << 0)  ///< `Madt::flags`: dual 8259 PICs are installed.
+/** @} */
+
+/**
+ * @defgroup mps_inti_flags MPS INTI Flags
+ * @brief Polarity and trigger mode of an interrupt source override.
+ * @{
+ */
+#define MPS_POLARITY_MASK 0x3  ///< Polarity field.
+#define MPS_POLARITY_LOW 0x3   ///< Active low.
+#define MPS_TRIGGER_MASK 0xc   ///< Trigger mode field.
+#define MPS_TRIGGER_LEVEL 0xc  ///< Level triggered.
+/** @} */
+
+/**
+ * @brief Multiple APIC Description Table, followed by its variable length entries.
+ */
+struct Madt {
+  AcpiHeader header;       ///< Header with signature `APIC`.
+  uint32_t lapic_address;  ///< Physical address of the local APICs.
+  uint32_t flags;          ///< `MADT_PCAT_COMPAT`.
+} __PACKED;
+
+/**
+ * @brief Header of every MADT entry.
+ */
+struct MadtEntry {
+  uint8_t type;    ///< `MADT_*` entry type.
+  uint8_t length;  ///< Size of the entry including this header.
+} __PACKED;
+
+/**
+ * @brief MADT entry of an I/O APIC.
+ */
+struct MadtIoapic {
+  MadtEntry entry;    ///< Type `MADT_IOAPIC`.
+  uint8_t id;         ///< I/O APIC ID.
+  uint8_t reserved;   ///< Reserved.
+  uint32_t address;   ///< Physical address of the registers.
+  uint32_t gsi_base;  ///< Global system interrupt of the first input.
+} __PACKED;
+
+/**
+ * @brief MADT entry that connects an ISA IRQ to another global system interrupt.
+ */
+struct MadtSourceOverride {
+  MadtEntry entry;  ///< Type `MADT_SOURCE_OVERRIDE`.
+  uint8_t bus;      ///< Always 0, ISA.
+  uint8_t source;   ///< ISA IRQ.
+  uint32_t gsi;     ///< Global system interrupt the IRQ is connected to.
+  uint16_t flags;   ///< MPS INTI polarity and trigger mode.
+} __PACKED;
+
+/**
+ * @brief Returns the table with the four character `signature`.
+ * @return `nullptr` if the firmware has no such table, or no valid one.
+ * @note Requires the physical allocator, tables outside the direct map are mapped on lookup.
+ */
+const AcpiHeader* acpi_find_table(const char* signature);
+
+#endif  // KERNEL_DRIVERS_ACPI_HPP
\ No newline at end of file
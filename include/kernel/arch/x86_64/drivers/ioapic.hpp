@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief Provides the I/O APIC driver, which routes device interrupts to the local APICs.
+ *
+ * Every input of an I/O APIC is a global system interrupt (GSI). The MADT lists the I/O APICs with
+ * the first GSI each one serves, and the interrupt source overrides of ISA IRQs that are not
+ * connected to the GSI with the same number, e.g. the PIT on GSI 2, or that are level triggered.
+ * The legacy 8259 PICs are masked once the I/O APICs took over.
+ *
+ * A routed GSI gets a vector from the dynamic range and is delivered in physical destination mode
+ * to the local APIC of one processor. Its affinity can be changed at any time, which only rewrites
+ * the destination of the redirection entry, so device interrupts can follow the processor that
+ * consumes their data. Handlers signal the end of interrupt with `lapic_eoi`, which also ends a
+ * level triggered interrupt at the I/O APIC.
+ *
+ * Key components:
+ * - `ioapic_initialize`: Finds the I/O APICs and the ISA overrides and masks every input.
+ * - `ioapic_route` / `ioapic_route_isa`: Attach a handler to a GSI or an ISA IRQ.
+ * - `ioapic_set_affinity`: Steers a routed GSI to another processor.
+ * - `ioapic_mask` / `ioapic_unmask` / `ioapic_release`: Manage a routed GSI.
+ */
+#ifndef KERNEL_DRIVERS_IOAPIC_HPP
+#define KERNEL_DRIVERS_IOAPIC_HPP 1
+
+#include <cstdint>
+
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+
+#define IOAPIC_MAX_CONTROLLERS 8  ///< I/O APICs the driver manages.
+#define IOAPIC_MAX_GSIS 256       ///< Global system interrupts the driver can route.
+#define ISA_IRQ_COUNT 16          ///< IRQs of the ISA bus.
+
+/**
+ * @defgroup ioapic_modes I/O APIC Input Modes
+ * @brief Electrical properties of a GSI, edge triggered and active high unless set.
+ * @{
+ */
+#define IOAPIC_ACTIVE_LOW (1u << 0)  ///< The input is active low.
+#define IOAPIC_LEVEL (1u << 1)       ///< The input is level triggered.
+/** @} */
+
+/**
+ * @brief Masks every I/O APIC input and the legacy PICs, and reads the ISA overrides of the MADT.
+ * @details Must be called once, on the boot processor, after the physical memory allocator was
+ * initialized.
+ * @return `false` if the firmware reports no I/O APIC.
+ */
+bool ioapic_initialize();
+
+/**
+ * @brief Returns the GSI the ISA IRQ `irq` is connected to.
+ */
+uint32_t ioapic_isa_gsi(uint8_t irq);
+
+/**
+ * @brief Routes `gsi` to `handler` on the processor with index `cpu` and unmasks it.
+ *
+ * @param mode `IOAPIC_*` input mode of the GSI.
+ * @return The vector the GSI raises, or 0 if the GSI does not exist, is already routed, the
+ * processor cannot be addressed or no vector is free.
+ */
+uint8_t ioapic_route(uint32_t gsi, uint32_t mode, uint32_t cpu, InterruptHandler handler,
+                     void* data = nullptr);
+
+/**
+ * @brief Routes the ISA IRQ `irq` like `ioapic_route`, with the GSI and mode of its override.
+ */
+uint8_t ioapic_route_isa(uint8_t irq, uint32_t cpu, InterruptHandler handler, void* data = nullptr);
+
+/**
+ * @brief Delivers the routed `gsi` to the processor with index `cpu` from now on.
+ * @details An interrupt that is already in flight may still arrive at the previous processor.
+ * @return `false` if the GSI is not routed or the processor cannot be addressed.
+ */
+bool ioapic_set_affinity(uint32_t gsi, uint32_t cpu);
+
+/// @brief Stops the delivery of the routed `gsi`, interrupts raised meanwhile are lost.
+void ioapic_mask(uint32_t gsi);
+
+/// @brief Resumes the delivery of the routed `gsi`.
+void ioapic_unmask(uint32_t gsi);
+
+/**
+ * @brief Masks `gsi` and frees its vector.
+ * @details A handler that already started keeps running, see `interrupt_unregister`.
+ */
+void ioapic_release(uint32_t gsi);
+
+#endif  // KERNEL_DRIVERS_IOAPIC_HPP
\ No newline at end of file
@@ -0,0 +1,25 @@
+/**
+ * @file
+ * @brief Provides the legacy programmable interval timer (PIT) as a reference clock.
+ *
+ * The PIT counts at a fixed 1.193182 MHz on every PC compatible machine, so it is used to measure
+ * the frequency of other clocks when the processor does not report it. Channel 2 is used because
+ * its output can be polled through the speaker gate port without an interrupt.
+ *
+ * @note The PIT has no locking, only one processor may use it at a time.
+ */
+#ifndef KERNEL_DRIVERS_PIT_HPP
+#define KERNEL_DRIVERS_PIT_HPP 1
+
+#include <cstdint>
+
+#define PIT_FREQUENCY 1193182u  ///< Input clock of the PIT in Hz.
+#define PIT_MAX_DELAY_MS 50     ///< Longest delay that fits the 16 bit counter.
+
+/**
+ * @brief Busy-waits for `ms` milliseconds and returns the TSC cycles that passed.
+ * @param ms Delay in milliseconds, at most `PIT_MAX_DELAY_MS`.
+ */
+uint64_t pit_measure_tsc(uint32_t ms);
+
+#endif  // KERNEL_DRIVERS_PIT_HPP
\ No newline at end of file
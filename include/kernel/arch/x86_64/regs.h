@@ -19,8 +19,57 @@
  * @brief Macros related to interrupt stack configuration.
  * @{
  */
-#define INTERRUPT_STACK_SIZE (4096)                ///< Size of the interrupt stack in bytes.
-#define PERCPU_INTERRUPT_STACKS_NMI_OFFSET 0x20e0  ///< Offset for per-CPU NMI stacks.
+#define INTERRUPT_STACK_SIZE (4096)  ///< Size of the interrupt stack in bytes.
+
+/**
+ * @brief Bytes reserved at the top of every interrupt stack, holding the address of the `PerCpu`
+ * block that owns the stack. The interrupt frame ends right below it.
+ */
+#define INTERRUPT_STACK_RESERVED 16
+
+/**
+ * @brief Size of the per-CPU stack system calls and interrupts from user mode run on.
+ */
+#define KERNEL_STACK_SIZE (16384)
+/** @} */
+
+/**
+ * @defgroup segment_selectors Segment Selectors
+ * @brief Selectors of the GDT entries. The user data segment directly precedes the user code
+ * segment, the order `sysretq` derives both from `MSR_STAR`.
+ * @{
+ */
+#define KERNEL_CODE_SELECTOR (1 * 8)  ///< 64-bit kernel code segment.
+#define KERNEL_DATA_SELECTOR (2 * 8)  ///< Kernel data and stack segment.
+#define USER_DATA_SELECTOR (3 * 8)    ///< User data and stack segment.
+#define USER_CODE_SELECTOR (4 * 8)    ///< 64-bit user code segment.
+#define TSS_SELECTOR (5 * 8)          ///< Task state segment of the executing processor.
+#define SELECTOR_RPL_USER 3           ///< Requested privilege level of user mode selectors.
+/** @} */
+
+/**
+ * @defgroup percpu_offsets Per-CPU Offsets
+ * @brief Offsets of fields in `PerCpu`, which the GS base points to while in the kernel.
+ * @{
+ */
+#define PERCPU_SELF_OFFSET 0              ///< Offset of the pointer to the block itself.
+#define PERCPU_INDEX_OFFSET 8             ///< Offset of the CPU index.
+#define PERCPU_INTERRUPT_STATS_OFFSET 64  ///< Offset of the per-vector interrupt statistics.
+
+/// @brief Offset of the pending software interrupts, right after the interrupt statistics.
+#define PERCPU_SOFTIRQ_PENDING_OFFSET \
+  (PERCPU_INTERRUPT_STATS_OFFSET + (256 << INTERRUPT_STATS_SHIFT))
+
+#define INTERRUPT_STATS_SHIFT 4  ///< Log2 of the size of the statistics of one vector.
+
+/// @brief Offset of the top of the stack `syscall_entry` switches to.
+#define PERCPU_KERNEL_STACK_OFFSET (PERCPU_SOFTIRQ_PENDING_OFFSET + 8)
+/// @brief Offset of the user stack pointer saved by `syscall_entry`.
+#define PERCPU_USER_STACK_OFFSET (PERCPU_SOFTIRQ_PENDING_OFFSET + 16)
+/// @brief Offset of the kernel stack pointer `user_exit` returns on.
+#define PERCPU_USER_RETURN_OFFSET (PERCPU_SOFTIRQ_PENDING_OFFSET + 24)
+/// @brief Offset of the flag requesting `fpu_load` before returning to user mode.
+#define PERCPU_FPU_LOAD_OFFSET (PERCPU_SOFTIRQ_PENDING_OFFSET + 32)
 /** @} */
 
 /**
@@ -28,21 +77,23 @@
  * @brief Macros defining offsets within the interrupt frame (iframe).
  * @{
  */
-#define IFRAME_OFFSET_RDI (0 * 8)       ///< Offset for the RDI register in iframe.
-#define IFRAME_OFFSET_RSI (1 * 8)       ///< Offset for the RSI register in iframe.
-#define IFRAME_OFFSET_RBP (2 * 8)       ///< Offset for the RBP register in iframe.
-#define IFRAME_OFFSET_RBX (3 * 8)       ///< Offset for the RBX register in iframe.
-#define IFRAME_OFFSET_RDX (4 * 8)       ///< Offset for the RDX register in iframe.
-#define IFRAME_OFFSET_RCX (5 * 8)       ///< Offset for the RCX register in iframe.
-#define IFRAME_OFFSET_RAX (6 * 8)       ///< Offset for the RAX register in iframe.
-#define IFRAME_OFFSET_VECTOR (7 * 8)    ///< Offset for the interrupt vector in iframe.
-#define IFRAME_OFFSET_ERR_CODE (8 * 8)  ///< Offset for the error code in iframe.
-#define IFRAME_OFFSET_RIP (9 * 8)       ///< Offset for the RIP register in iframe.
-#define IFRAME_OFFSET_CS (10 * 8)       ///< Offset for the code segment in iframe.
-#define IFRAME_OFFSET_RFLAGS (11 * 8)   ///< Offset for the RFLAGS register in iframe.
-#define IFRAME_OFFSET_RSP (12 * 8)      ///< Offset for the RSP register in iframe.
-#define IFRAME_OFFSET_USER_SS (13 * 8)  ///< Offset for the user segment selector in iframe.
-#define IFRAME_SIZE (14 * 8)            ///< Total size of the iframe in bytes.
+#define IFRAME_OFFSET_RDI (0 * 8)        ///< Offset for the RDI register in iframe.
+#define IFRAME_OFFSET_RSI (1 * 8)        ///< Offset for the RSI register in iframe.
+#define IFRAME_OFFSET_RBP (2 * 8)        ///< Offset for the RBP register in iframe.
+#define IFRAME_OFFSET_RBX (3 * 8)        ///< Offset for the RBX register in iframe.
+#define IFRAME_OFFSET_RDX (4 * 8)        ///< Offset for the RDX register in iframe.
+#define IFRAME_OFFSET_RCX (5 * 8)        ///< Offset for the RCX register in iframe.
+#define IFRAME_OFFSET_RAX (6 * 8)        ///< Offset for the RAX register in iframe.
+#define IFRAME_OFFSET_R8 (7 * 8)         ///< Offset for the R8 register in iframe.
+#define IFRAME_OFFSET_R15 (14 * 8)       ///< Offset for the R15 register in iframe.
+#define IFRAME_OFFSET_VECTOR (15 * 8)    ///< Offset for the interrupt vector in iframe.
+#define IFRAME_OFFSET_ERR_CODE (16 * 8)  ///< Offset for the error code in iframe.
+#define IFRAME_OFFSET_RIP (17 * 8)       ///< Offset for the RIP register in iframe.
+#define IFRAME_OFFSET_CS (18 * 8)        ///< Offset for the code segment in iframe.
+#define IFRAME_OFFSET_RFLAGS (19 * 8)    ///< Offset for the RFLAGS register in iframe.
+#define IFRAME_OFFSET_RSP (20 * 8)       ///< Offset for the RSP register in iframe.
+#define IFRAME_OFFSET_USER_SS (21 * 8)   ///< Offset for the user segment selector in iframe.
+#define IFRAME_SIZE (22 * 8)             ///< Total size of the iframe in bytes.
 /** @} */
 
 /**
@@ -95,6 +146,20 @@
 #define EFER_NXE 0x00000800  ///< Enable Execute-Disable bit.
 /** @} */
 
+/**
+ * @defgroup xcr0_registers XCR0 Register
+ * @brief State components enabled for XSAVE in extended control register 0.
+ * @{
+ */
+#define XCR0_X87 (1ul << 0)        ///< x87 FPU state.
+#define XCR0_SSE (1ul << 1)        ///< XMM registers and MXCSR.
+#define XCR0_AVX (1ul << 2)        ///< Upper halves of the YMM registers.
+#define XCR0_OPMASK (1ul << 5)     ///< AVX-512 opmask registers.
+#define XCR0_ZMM_HI256 (1ul << 6)  ///< Upper halves of ZMM0 to ZMM15.
+#define XCR0_HI16_ZMM (1ul << 7)   ///< ZMM16 to ZMM31.
+#define XCR0_AVX512 (XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM)  ///< All AVX-512 state.
+/** @} */
+
 /**
  * @defgroup msr_registers Model-Specific Registers (MSRs)
  * @brief Definitions and flags for MSRs.
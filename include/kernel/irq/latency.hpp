@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @brief Provides optional interrupt latency instrumentation.
+ *
+ * When the kernel is configured with `-Denable-irq-latency=true`, two sources of interrupt latency
+ * are recorded per processor:
+ * - The time from the interrupt entry to the return of its handler, per vector, as a histogram
+ *   with power of two buckets of timestamp counter cycles.
+ * - The longest section with interrupts disabled through `arch_interrupt_save`, together with the
+ *   instruction that disabled them. Sections using `arch_disable_interrupts` directly and the
+ *   interrupt handlers themselves are not tracked as such, the latter are covered by the
+ *   histograms.
+ *
+ * Without the option the hooks are not called and the instrumentation is not part of the build.
+ *
+ * Key components:
+ * - `irq_latency_record`: Called by the interrupt entry code after a handler returned.
+ * - `irqsoff_begin` / `irqsoff_end`: Called when `arch_interrupt_save` disables interrupts and when
+ *   `arch_interrupt_restore` enables them again.
+ * - `irq_latency_dump`: Logs the histograms and the longest interrupts-off sections.
+ */
+#ifndef KERNEL_IRQ_LATENCY_HPP
+#define KERNEL_IRQ_LATENCY_HPP 1
+
+#include <cstdint>
+
+#define IRQ_LATENCY_BUCKETS 32  ///< Histogram buckets, the last one collects everything longer.
+
+#ifdef ENABLE_IRQ_LATENCY
+
+/**
+ * @brief Records that the handler of `vector` returned `cycles` after the interrupt entry.
+ * @details Called with interrupts disabled.
+ */
+extern "C" void irq_latency_record(uint64_t vector, uint64_t cycles);
+
+/**
+ * @brief Starts an interrupts-off section disabled at `ip`.
+ * @details Called with interrupts disabled.
+ */
+void irqsoff_begin(uintptr_t ip);
+
+/**
+ * @brief Ends the interrupts-off section of the executing processor.
+ * @details Called with interrupts still disabled.
+ */
+void irqsoff_end();
+
+/**
+ * @brief Logs the latency histograms of all vectors and the longest interrupts-off sections.
+ */
+void irq_latency_dump();
+
+#else
+
+inline void irq_latency_dump() {}
+
+#endif  // ENABLE_IRQ_LATENCY
+
+#endif  // KERNEL_IRQ_LATENCY_HPP
\ No newline at end of file
@@ -0,0 +1,110 @@
+/**
+ * @file
+ * @brief Provides software interrupts and tasklets, work deferred from hardware interrupt handlers.
+ *
+ * A hardware interrupt handler runs with interrupts disabled, so everything it does delays every
+ * other interrupt on its processor. Handlers should only acknowledge their device and raise a
+ * software interrupt, whose handler runs the rest of the work with interrupts enabled.
+ *
+ * Pending software interrupts are kept in a per-CPU bit mask. They run when the outermost hardware
+ * interrupt returns to a context with interrupts enabled, when `softirq_enable` ends the last
+ * section that deferred them, and from the idle loop. Software interrupts never nest and never run
+ * on another processor than the one that raised them.
+ *
+ * Tasklets are built on a software interrupt. A tasklet is a function that can be scheduled from
+ * any context and runs once per scheduling, never concurrently with itself.
+ *
+ * Key components:
+ * - `softirq_register` / `softirq_raise`: Install a handler and mark it pending.
+ * - `softirq_disable` / `softirq_enable`: Keep software interrupts from running on the executing
+ *   processor, e.g. while holding a lock that a software interrupt handler takes as well.
+ * - `Tasklet` / `tasklet_schedule`: Run a function once from a software interrupt.
+ *
+ * @note Handlers must not block. Like hardware interrupt handlers running while their processor
+ * idles, they are not RCU readers when raised from an idle processor.
+ */
+#ifndef KERNEL_IRQ_SOFTIRQ_HPP
+#define KERNEL_IRQ_SOFTIRQ_HPP 1
+
+#include <atomic>
+#include <cstdint>
+
+/// @brief Rounds of pending software interrupts run at a time before the rest is left to idle.
+#define SOFTIRQ_MAX_RESTARTS 10
+
+/**
+ * @brief Software interrupts, lower numbers run first.
+ */
+enum SoftirqType : uint32_t {
+  SOFTIRQ_TIMER,    ///< Expired timers.
+  SOFTIRQ_TASKLET,  ///< Scheduled tasklets.
+  SOFTIRQ_COUNT,
+};
+
+/// @brief Function run for a pending software interrupt, with interrupts enabled.
+using SoftirqHandler = void (*)();
+
+/**
+ * @brief Installs the tasklet software interrupt handler.
+ */
+void softirq_initialize();
+
+/**
+ * @brief Installs the handler of `type`.
+ * @details Must be called before `type` is raised for the first time.
+ */
+void softirq_register(SoftirqType type, SoftirqHandler handler);
+
+/**
+ * @brief Marks `type` pending on the executing processor.
+ * @details If called outside of an interrupt handler with software interrupts enabled, the
+ * handler runs at the next interrupt or when the processor idles.
+ */
+void softirq_raise(SoftirqType type);
+
+/// @brief Returns whether software interrupts are pending on the executing processor.
+bool softirq_pending();
+
+/**
+ * @brief Runs the pending software interrupts of the executing processor.
+ * @details Does nothing while software interrupts are disabled or already running. Called with
+ * interrupts disabled, which are enabled while the handlers run.
+ */
+void softirq_run();
+
+/**
+ * @brief Keeps software interrupts from running on the executing processor, counting nested calls.
+ */
+void softirq_disable();
+
+/**
+ * @brief Ends a section started by `softirq_disable`.
+ * @details The outermost call runs the software interrupts raised in the meantime.
+ */
+void softirq_enable();
+
+struct Tasklet;
+
+/// @brief Function run by a tasklet.
+using TaskletFunction = void (*)(Tasklet* tasklet);
+
+#define TASKLET_SCHEDULED (1u << 0)  ///< The tasklet is queued to run.
+#define TASKLET_RUNNING (1u << 1)    ///< The tasklet's function runs on some processor.
+
+/**
+ * @brief Function that runs once per `tasklet_schedule` from a software interrupt.
+ */
+struct Tasklet {
+  TaskletFunction function;         ///< Function run by the tasklet.
+  Tasklet* next = nullptr;          ///< Next tasklet in the queue of a processor.
+  std::atomic<uint32_t> state = 0;  ///< `TASKLET_SCHEDULED` and `TASKLET_RUNNING` flags.
+};
+
+/**
+ * @brief Queues `tasklet` to run on the executing processor.
+ * @details A tasklet scheduled again before it ran only runs once. A tasklet scheduled while it
+ * runs runs again afterwards, on the processor that scheduled it.
+ */
+void tasklet_schedule(Tasklet* tasklet);
+
+#endif  // KERNEL_IRQ_SOFTIRQ_HPP
\ No newline at end of file
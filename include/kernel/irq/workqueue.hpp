@@ -0,0 +1,57 @@
+/**
+ * @file
+ * @brief Provides work items that run in process context, outside of any interrupt.
+ *
+ * Work that is too long even for a software interrupt, or that needs to wait, is queued as a work
+ * item. Every processor has a work queue that is drained in batches: the worker takes all queued
+ * items with a single lock acquisition and runs them with interrupts enabled.
+ *
+ * Every processor has a worker thread, which blocks while its queue is empty and is woken with
+ * `thread_wake` by the first item queued, from any processor. An item may block or wait like any
+ * other thread, which the idle thread of a processor cannot. Items queued before the workers were
+ * started run once they are.
+ *
+ * Key components:
+ * - `Work`: A work item, embedded in the object it belongs to.
+ * - `work_queue` / `work_queue_on`: Queue an item on the executing or on another processor.
+ * - `workqueue_initialize`: Starts the workers.
+ */
+#ifndef KERNEL_IRQ_WORKQUEUE_HPP
+#define KERNEL_IRQ_WORKQUEUE_HPP 1
+
+#include <atomic>
+#include <cstdint>
+
+struct Work;
+
+/// @brief Function run by a work item.
+using WorkFunction = void (*)(Work* work);
+
+/**
+ * @brief Function that runs once per queueing in process context.
+ */
+struct Work {
+  WorkFunction function;              ///< Function run by the item.
+  Work* next = nullptr;               ///< Next item in the queue of a processor.
+  std::atomic<bool> pending = false;  ///< Set while the item is queued.
+};
+
+/**
+ * @brief Queues `work` on the executing processor.
+ * @return `false` if the item is already queued, it runs only once then.
+ */
+bool work_queue(Work* work);
+
+/**
+ * @brief Queues `work` on the processor with index `cpu`.
+ * @return `false` if the item is already queued, it runs only once then.
+ */
+bool work_queue_on(uint32_t cpu, Work* work);
+
+/**
+ * @brief Starts the worker thread of every processor that is online.
+ * @details Must be called after the kernel heap was initialized and the processors were started.
+ */
+void workqueue_initialize();
+
+#endif  // KERNEL_IRQ_WORKQUEUE_HPP
\ No newline at end of file
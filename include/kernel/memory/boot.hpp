@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief Provides the bump allocator used before the kernel heap is available.
+ *
+ * Early initialization code runs before the physical allocator has parsed the memory map, and
+ * many of the structures it sets up are far smaller than a page. The boot arena hands out memory
+ * by bumping a pointer, first through a static region in `.bss` and then through chunks carved off
+ * the start of the first usable memory map entry. Carved chunks are removed from the memory map,
+ * so the physical allocator never sees them as free.
+ *
+ * Key components:
+ * - `boot_alloc`: Bump allocation with arbitrary alignment. `kmalloc` and `operator new` fall back
+ *   to it until the kernel heap is initialized.
+ * - `boot_arena_mark` / `boot_arena_release`: Rewind the arena to an earlier state, freeing all
+ *   allocations made in between. `BootArenaScope` does the same for a scope.
+ * - `boot_arena_handover`: Hands the carved chunks to the physical allocator. Pages with live
+ *   allocations stay reserved, the rest are returned as free memory.
+ *
+ * @note The arena is only used while the boot processor is the only one running and is therefore
+ * not synchronized.
+ */
+#ifndef KERNEL_MEMORY_BOOT_HPP
+#define KERNEL_MEMORY_BOOT_HPP 1
+
+#include <compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel/memory/memory.hpp>
+
+#define BOOT_ARENA_STATIC_SIZE (16 * PAGE_SIZE_4KiB)  ///< Size of the region in `.bss`.
+#define BOOT_ARENA_CHUNK_SIZE (16 * PAGE_SIZE_4KiB)   ///< Size of a chunk from the memory map.
+#define BOOT_ARENA_MAX_CHUNKS 16                      ///< Maximum number of regions in total.
+#define BOOT_ARENA_DEFAULT_ALIGN 16                   ///< Alignment used by `kmalloc` fallbacks.
+
+/**
+ * @brief Saved state of the boot arena.
+ */
+struct BootArenaMark {
+  size_t chunk;  ///< Index of the region being allocated from.
+  size_t used;   ///< Bytes used in that region.
+};
+
+/**
+ * @brief Allocates memory from the boot arena.
+ *
+ * @param size Number of bytes, at most `BOOT_ARENA_CHUNK_SIZE`.
+ * @param align Required alignment, a power of two.
+ * @return The allocation, or `nullptr` if the arena is exhausted or was already handed over.
+ */
+void* boot_alloc(size_t size, size_t align = BOOT_ARENA_DEFAULT_ALIGN) __MALLOC __ALLOC_SIZE(1);
+
+/// @brief Captures the current state of the boot arena.
+BootArenaMark boot_arena_mark();
+
+/**
+ * @brief Frees every allocation made since `mark` was taken.
+ * @details Chunks emptied this way are kept and reused before new ones are carved.
+ */
+void boot_arena_release(const BootArenaMark& mark);
+
+/// @brief Checks whether `ptr` points into memory managed by the boot arena.
+bool boot_arena_owns(const void* ptr);
+
+/**
+ * @brief Hands the carved chunks over to the physical allocator and closes the arena.
+ *
+ * @details Live allocations remain valid forever, freeing them through `kfree` is a no-op. Must be
+ * called after `PhysicalAllocator::initialize`.
+ */
+void boot_arena_handover();
+
+/**
+ * @brief Frees all boot arena allocations made within a scope.
+ */
+class BootArenaScope {
+ public:
+  BootArenaScope() : m_mark(boot_arena_mark()) {}
+  ~BootArenaScope() { boot_arena_release(this->m_mark); }
+
+  BootArenaScope(const BootArenaScope&) = delete;
+  BootArenaScope& operator=(const BootArenaScope&) = delete;
+
+ private:
+  BootArenaMark m_mark;
+};
+
+#endif  // KERNEL_MEMORY_BOOT_HPP
\ No newline at end of file
@@ -111,7 +111,7 @@ constexpr bool is_aligned(std::unsigned_integral auto num, std::unsigned_integra
  * @param base The divisor.
  * @return The quotient, rounded up.
  */
-constexpr bool div_round_up(std::unsigned_integral auto num, std::unsigned_integral auto base) {
+constexpr auto div_round_up(std::unsigned_integral auto num, std::unsigned_integral auto base) {
   return align_up(num, base) / base;
 }
 
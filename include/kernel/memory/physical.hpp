@@ -5,18 +5,45 @@
 #include <cstdint>
 
 #include <common/bitmap.hpp>
+#include <kernel/sync/percpu_counter.hpp>
+#include <lock.hpp>
 
 class PhysicalAllocator {
  public:
   explicit PhysicalAllocator() = default;
 
   template <typename T = void*>
-  T allocate(size_t size) {
-    return this->allocate(size);
+  T allocate(size_t size, size_t alignment = 0) {
+    return reinterpret_cast<T>(this->allocate(size, alignment));
   }
 
-  uintptr_t allocate(size_t size);
-  void free(auto ptr, size_t size);
+  /**
+   * @brief Allocates zeroed, physically contiguous pages.
+   *
+   * @param size Number of bytes to allocate, rounded up to whole pages.
+   * @param alignment Required alignment of the first page in bytes. Values below the page size
+   * mean page alignment.
+   * @return Physical address of the first page.
+   */
+  uintptr_t allocate(size_t size, size_t alignment = 0);
+
+  /**
+   * @brief Returns pages obtained from `allocate` back to the allocator.
+   *
+   * @param addr Physical address of the first page.
+   * @param size Size that was passed to `allocate`.
+   */
+  void free(uintptr_t addr, size_t size);
+
+  /**
+   * @brief Takes ownership of pages that were removed from the memory map before initialization.
+   *
+   * @param addr Physical address of the first page.
+   * @param size Size of the region in bytes, a multiple of the page size.
+   * @param used Bytes at the start of the region that stay allocated; the rest becomes free.
+   */
+  void adopt(uintptr_t addr, size_t size, size_t used);
+
   void initialize();
   void info() const;
 
@@ -26,10 +53,17 @@ class PhysicalAllocator {
 
   size_t m_total_pages;   ///< Total number of pages in physical memory.
   size_t m_usable_pages;  ///< Number of pages available for use.
-  size_t m_used_pages;    ///< Number of pages currently allocated.
   size_t m_last_used_idx;
 
+  PercpuCounter<> m_used_pages;  ///< Pages currently allocated, updated outside `m_lock`.
+
   Bitmap m_bitmap;
+  TicketLock m_lock;  ///< Held with interrupts disabled.
 };
 
+/**
+ * @brief The system-wide physical page allocator.
+ */
+extern PhysicalAllocator phys_allocator;
+
 #endif  // KERNEL_MEMORY_PHYSICAL_HPP
\ No newline at end of file
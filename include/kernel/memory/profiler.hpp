@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @brief Provides an optional allocation profiler that attributes memory usage to call sites.
+ *
+ * When the kernel is configured with `-Denable-alloc-profiler=true`, every allocation made through
+ * the kernel heap and the physical allocator is recorded with the return address of its caller,
+ * its size and a timestamp. Live allocations are kept in a fixed size open-addressing hash table
+ * keyed by address, and per call site totals in a second table keyed by return address, so the
+ * profiler never allocates memory itself.
+ *
+ * Each processor counts its call sites in a table of its own, like the lock statistics do, and
+ * the allocation table is split into shards with a lock each, so profiled allocations on
+ * different processors rarely touch the same cache lines. `alloc_profiler_dump` merges the tables.
+ *
+ * Without the option all hooks expand to nothing and the profiler is not part of the build.
+ *
+ * Key components:
+ * - `alloc_profile_alloc` / `alloc_profile_free`: Hooks placed in the allocators.
+ * - `alloc_profiler_dump`: Logs the top call sites by live bytes and by allocation rate.
+ */
+#ifndef KERNEL_MEMORY_PROFILER_HPP
+#define KERNEL_MEMORY_PROFILER_HPP 1
+
+#include <compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#define ALLOC_PROFILER_SITES 512              ///< Call sites tracked per processor, a power of two.
+#define ALLOC_PROFILER_ALLOCATIONS (1 << 16)  ///< Capacity of the allocation table, a power of two.
+#define ALLOC_PROFILER_SHARDS 64              ///< Locked shards of the allocation table.
+#define ALLOC_PROFILER_DEFAULT_TOP 10         ///< Call sites listed per ranking by default.
+
+/**
+ * @brief Allocator an allocation was made from.
+ */
+enum AllocSource : uint8_t {
+  ALLOC_SOURCE_HEAP = 0,      ///< `kmalloc`, `kmem_cache_alloc` and `operator new`.
+  ALLOC_SOURCE_PHYSICAL = 1,  ///< `PhysicalAllocator::allocate`.
+};
+
+#ifdef ENABLE_ALLOC_PROFILER
+
+/**
+ * @brief Records an allocation.
+ *
+ * @param source Allocator the memory came from.
+ * @param address Address of the allocation.
+ * @param size Size of the allocation in bytes.
+ * @param caller Return address of the allocator's caller.
+ */
+void alloc_profiler_record(AllocSource source, uintptr_t address, size_t size, uintptr_t caller);
+
+/**
+ * @brief Records that an allocation was freed. Unknown addresses are ignored.
+ */
+void alloc_profiler_forget(AllocSource source, uintptr_t address);
+
+/**
+ * @brief Logs the call sites with the most live bytes and with the highest allocation rate.
+ * @param top Number of call sites to list per ranking.
+ */
+void alloc_profiler_dump(size_t top = ALLOC_PROFILER_DEFAULT_TOP);
+
+/// @brief Converts a pointer passed to the hooks to an address.
+inline uintptr_t alloc_profiler_address(const void* address) {
+  return reinterpret_cast<uintptr_t>(address);
+}
+
+/// @brief Passes an address given to the hooks as an integer through unchanged.
+inline uintptr_t alloc_profiler_address(uintptr_t address) { return address; }
+
+#define alloc_profile_alloc(source, address, size, caller)                 \
+  alloc_profiler_record((source), alloc_profiler_address(address), (size), \
+                        alloc_profiler_address(caller))
+#define alloc_profile_free(source, address) \
+  alloc_profiler_forget((source), alloc_profiler_address(address))
+
+#else
+
+#define alloc_profile_alloc(source, address, size, caller) WRAP_MACRO()
+#define alloc_profile_free(source, address) WRAP_MACRO()
+
+inline void alloc_profiler_dump(size_t = ALLOC_PROFILER_DEFAULT_TOP) {}
+
+#endif  // ENABLE_ALLOC_PROFILER
+
+#endif  // KERNEL_MEMORY_PROFILER_HPP
\ No newline at end of file
@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @brief Provides polymorphic memory resources and an allocator adaptor for standard containers.
+ *
+ * The interface follows `std::pmr`, which is not part of the freestanding library. A subsystem that
+ * wants its allocations kept together, or released all at once, owns a `MemoryResource` and hands a
+ * `PolymorphicAllocator` to its containers. Everything else uses the kernel heap, which also backs
+ * the global `operator new` and `operator delete`.
+ *
+ * Key components:
+ * - `MemoryResource`: Abstract interface of an allocator.
+ * - `heap_resource`: Resource backed by `kmalloc_aligned` and `kfree`.
+ * - `ArenaResource`: Monotonic arena that carves allocations out of large chunks from an upstream
+ *   resource and gives all of them back at once in `release`.
+ * - `PolymorphicAllocator`: Standard allocator that forwards to a `MemoryResource`.
+ */
+#ifndef KERNEL_MEMORY_RESOURCE_HPP
+#define KERNEL_MEMORY_RESOURCE_HPP 1
+
+#include <log.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel/memory/memory.hpp>
+
+#define ARENA_MIN_CHUNK_SIZE (4 * PAGE_SIZE_4KiB)   ///< Size of the first chunk of an arena.
+#define ARENA_MAX_CHUNK_SIZE (64 * PAGE_SIZE_4KiB)  ///< Chunks stop growing beyond this size.
+
+/**
+ * @brief Abstract source of memory, modelled after `std::pmr::memory_resource`.
+ *
+ * @details Unlike the standard class, the destructor is protected and non-virtual. Resources are
+ * never deleted through the base class, and a trivial destructor keeps global resources free of
+ * exit-time destructor registration, which the kernel has no support for.
+ */
+class MemoryResource {
+ public:
+  constexpr MemoryResource() = default;
+
+  MemoryResource(const MemoryResource&) = delete;
+  MemoryResource& operator=(const MemoryResource&) = delete;
+
+  /**
+   * @brief Allocates `bytes` bytes aligned to `align`.
+   * @return The allocation, or `nullptr` if the resource is exhausted.
+   */
+  void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+    return this->do_allocate(bytes, align);
+  }
+
+  /// @brief Returns memory obtained from `allocate` with the same size and alignment.
+  void deallocate(void* ptr, size_t bytes, size_t align = alignof(std::max_align_t)) {
+    this->do_deallocate(ptr, bytes, align);
+  }
+
+  /// @brief Checks whether memory allocated from one resource can be freed through the other.
+  bool is_equal(const MemoryResource& other) const {
+    return this == &other || this->do_is_equal(other);
+  }
+
+ protected:
+  virtual void* do_allocate(size_t bytes, size_t align) = 0;
+  virtual void do_deallocate(void* ptr, size_t bytes, size_t align) = 0;
+  virtual bool do_is_equal(const MemoryResource& other) const { return this == &other; }
+
+  ~MemoryResource() = default;
+};
+
+/**
+ * @brief Returns the resource backed by the kernel heap.
+ */
+MemoryResource* heap_resource();
+
+/**
+ * @brief Monotonic arena for allocations that share a lifetime.
+ *
+ * @details Allocation bumps a pointer through the current chunk and `deallocate` is a no-op. When a
+ * chunk runs out, a new one twice the size of the last is taken from the upstream resource, up to
+ * `ARENA_MAX_CHUNK_SIZE`. The arena is not thread safe; callers serialize access themselves.
+ */
+class ArenaResource final : public MemoryResource {
+ public:
+  explicit ArenaResource(MemoryResource* upstream = heap_resource(),
+                         size_t chunk_size = ARENA_MIN_CHUNK_SIZE)
+      : m_upstream(upstream), m_next_chunk_size(chunk_size) {}
+
+  ~ArenaResource() { this->release(); }
+
+  /// @brief Frees every allocation of the arena by returning all chunks to the upstream resource.
+  void release();
+
+  /// @brief Number of bytes handed out since the last `release`.
+  size_t allocated() const { return this->m_allocated; }
+
+ protected:
+  void* do_allocate(size_t bytes, size_t align) override;
+  void do_deallocate(void*, size_t, size_t) override {}
+
+ private:
+  struct Chunk {
+    Chunk* next;  ///< Previously allocated chunk.
+    size_t size;  ///< Size of the chunk including this header.
+  };
+
+  MemoryResource* m_upstream;
+  size_t m_next_chunk_size;
+
+  Chunk* m_chunks = nullptr;
+  uintptr_t m_cursor = 0;  ///< Next free byte of the current chunk.
+  uintptr_t m_end = 0;     ///< End of the current chunk.
+  size_t m_allocated = 0;
+};
+
+/**
+ * @brief Allocator that forwards to a `MemoryResource`, usable with standard containers.
+ *
+ * @details A default constructed allocator uses the kernel heap. Two allocators compare equal if
+ * their resources do.
+ */
+template <typename T>
+class PolymorphicAllocator {
+ public:
+  using value_type = T;
+
+  PolymorphicAllocator() : m_resource(heap_resource()) {}
+  PolymorphicAllocator(MemoryResource* resource) : m_resource(resource) {}
+
+  template <typename U>
+  PolymorphicAllocator(const PolymorphicAllocator<U>& other)
+      : m_resource(other.resource()) {}
+
+  /**
+   * @brief Allocates storage for `count` objects.
+   * @details Containers never check the result, exceptions are disabled, so an overflowing count
+   * or an exhausted resource panics like the global `operator new`. Use `MemoryResource::allocate`
+   * directly to handle failures.
+   */
+  T* allocate(size_t count) {
+    size_t bytes = 0;
+
+    if (__builtin_mul_overflow(count, sizeof(T), &bytes)) {
+      log_panic("Allocation of %lu objects of %lu bytes overflows.", count, sizeof(T));
+    }
+
+    void* ptr = this->m_resource->allocate(bytes, alignof(T));
+
+    if (!ptr) {
+      log_panic("Out of memory allocating %lu bytes from a memory resource.", bytes);
+    }
+
+    return static_cast<T*>(ptr);
+  }
+
+  void deallocate(T* ptr, size_t count) {
+    this->m_resource->deallocate(ptr, count * sizeof(T), alignof(T));
+  }
+
+  MemoryResource* resource() const { return this->m_resource; }
+
+  template <typename U>
+  bool operator==(const PolymorphicAllocator<U>& other) const {
+    return this->m_resource->is_equal(*other.resource());
+  }
+
+ private:
+  MemoryResource* m_resource;
+};
+
+#endif  // KERNEL_MEMORY_RESOURCE_HPP
\ No newline at end of file
@@ -0,0 +1,30 @@
+/**
+ * @file
+ * @brief Provides memory routines using vector instructions.
+ *
+ * The routines are compiled in SIMD translation units and must be called between
+ * `kernel_fpu_begin` and `kernel_fpu_end`. Callers use the scalar routines instead where
+ * `kernel_fpu_usable` is false.
+ *
+ * Key components:
+ * - `zero_stream_sse2`: Zeroes memory with non-temporal stores.
+ */
+#ifndef KERNEL_MEMORY_SIMD_HPP
+#define KERNEL_MEMORY_SIMD_HPP 1
+
+#include <cstddef>
+
+/**
+ * @brief Smallest range worth zeroing with non-temporal stores.
+ * @details Smaller ranges are likely used soon after and are better zeroed into the cache.
+ */
+#define ZERO_STREAM_MIN_SIZE (64 * 1024)
+
+/**
+ * @brief Zeroes `size` bytes at `addr` with SSE2 non-temporal stores, bypassing the caches.
+ * @param addr Start of the range, 16 byte aligned.
+ * @param size Size of the range, a multiple of 64 bytes.
+ */
+void zero_stream_sse2(void* addr, size_t size);
+
+#endif  // KERNEL_MEMORY_SIMD_HPP
\ No newline at end of file
@@ -0,0 +1,263 @@
+/**
+ * @file
+ * @brief Provides an object-caching slab allocator and the general purpose kernel heap.
+ *
+ * Objects are carved out of slabs: physically contiguous runs of pages, aligned to their own size,
+ * that carry their bookkeeping header at the very start. A `SlabCache` manages objects of a single
+ * size and keeps its slabs on full, partial and empty lists, so that both allocation and free are
+ * O(1) list operations.
+ *
+ * On top of the slabs sits a per-CPU magazine layer in the style of Bonwick and Adams. Every CPU
+ * owns a loaded and a previous magazine per cache, each a small stack of free objects. Allocation
+ * and free only touch these CPU-local magazines with interrupts disabled, and the cache lock is
+ * only taken to exchange a whole magazine with the depot or when the depot runs dry. The cache
+ * and depot locks, like the lock of the page allocator, are held with interrupts disabled, so the
+ * heap can be used from interrupt handlers and software interrupts.
+ *
+ * Key components:
+ * - `kmem_cache_create`: Creates a typed object cache with an optional constructor and destructor.
+ *   Objects stay in their constructed state while cached, so the constructor runs when a slab is
+ *   created and the destructor when it is reclaimed, not on every allocation.
+ * - `kmalloc` / `kfree`: General purpose allocation through power-of-two size classes from
+ *   `KMALLOC_MIN_SIZE` up to `KMALLOC_MAX_SIZE`. Larger requests go straight to the page allocator.
+ * - Cache coloring: Each new slab shifts its first object by another cache line, so objects with
+ *   the same index in different slabs do not all map onto the same cache sets.
+ * - Empty slab reclaim: Free slabs beyond `SLAB_EMPTY_RESERVE` are returned to the page allocator
+ *   immediately, and `kmem_reap` drains the remaining reserve of every cache on demand.
+ * - Magazines and depot: Per-CPU caches of `MAGAZINE_ROUNDS` objects backed by a per-cache depot
+ *   of full and empty magazines.
+ */
+#ifndef KERNEL_MEMORY_SLAB_HPP
+#define KERNEL_MEMORY_SLAB_HPP 1
+
+#include <compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <common/list.hpp>
+#include <kernel/arch/arch.hpp>
+#include <kernel/memory/memory.hpp>
+#include <lock.hpp>
+
+#define KMALLOC_MIN_SHIFT 3                                     ///< Smallest size class (8 B).
+#define KMALLOC_MAX_SHIFT 12                                    ///< Largest size class (4 KiB).
+#define KMALLOC_MIN_SIZE (1ul << KMALLOC_MIN_SHIFT)             ///< Smallest kmalloc object.
+#define KMALLOC_MAX_SIZE (1ul << KMALLOC_MAX_SHIFT)             ///< Largest slab-backed object.
+#define KMALLOC_CLASSES (KMALLOC_MAX_SHIFT - KMALLOC_MIN_SHIFT + 1)  ///< Number of size classes.
+
+/**
+ * @brief Size of every slab backing a kmalloc size class.
+ *
+ * All kmalloc slabs share one size so that `kfree` can find the slab header of any pointer by
+ * rounding it down to this boundary. The header takes a whole object slot in the naturally aligned
+ * `KMALLOC_MAX_SIZE` class, so the slab holds 16 of those slots to keep the loss at one in 16.
+ */
+#define KMALLOC_SLAB_SIZE (16 * PAGE_SIZE_4KiB)
+
+#define SLAB_MIN_OBJECTS 8                 ///< Preferred minimum number of objects per slab.
+#define SLAB_MAX_SIZE (16 * PAGE_SIZE_4KiB)  ///< Upper bound on the size of a single slab.
+#define SLAB_EMPTY_RESERVE 1               ///< Empty slabs a cache keeps before reclaiming.
+
+#define MAGAZINE_ROUNDS 32  ///< Number of objects a magazine holds.
+
+/**
+ * @defgroup slab_flags Object cache flags
+ * @brief Flags accepted by `SlabCache::initialize`.
+ * @{
+ */
+#define SLAB_NO_MAGAZINES (1u << 0)  ///< Bypass the per-CPU layer and always take the cache lock.
+/** @} */
+
+/**
+ * @brief Callback used to construct or destruct cached objects.
+ * @param object Pointer to the object.
+ */
+using kmem_ctor_fn = void (*)(void* object);
+
+class SlabCache;
+
+/**
+ * @brief Header placed at the start of every slab.
+ */
+struct Slab : ListNode<> {
+  SlabCache* cache;  ///< Owning cache, or `nullptr` for a large kmalloc allocation.
+  void* freelist;    ///< First free object in this slab.
+  size_t size;       ///< Size of the slab in bytes.
+  uint32_t in_use;   ///< Number of allocated objects.
+  uint32_t color;    ///< Offset of the first object past the aligned header.
+  uint32_t magic;    ///< Identifies valid slab headers.
+};
+
+/**
+ * @brief Stack of free objects that a CPU allocates from without taking a lock.
+ */
+struct Magazine : ListNode<> {
+  size_t rounds = 0;               ///< Number of objects currently held.
+  void* objects[MAGAZINE_ROUNDS];  ///< Held objects, valid up to `rounds`.
+};
+
+/**
+ * @brief Magazines owned by a single CPU.
+ *
+ * @details `previous` is always either full or empty, only `loaded` may be partially filled. The
+ * structure fills a cache line of its own so that CPUs never write to a shared line.
+ */
+struct alignas(CACHE_LINE_SIZE) SlabCpuCache {
+  Magazine* loaded = nullptr;    ///< Magazine that allocations and frees operate on.
+  Magazine* previous = nullptr;  ///< Fallback magazine swapped in before going to the depot.
+};
+
+class SlabCache : public ListNode<> {
+ public:
+  constexpr SlabCache() = default;
+
+  /**
+   * @brief Prepares the cache for objects of the given size.
+   *
+   * @param name Human readable name, must outlive the cache.
+   * @param size Size of each object in bytes.
+   * @param align Required object alignment, a power of two.
+   * @param ctor Optional constructor run on every object when its slab is created.
+   * @param dtor Optional destructor run on every object when its slab is reclaimed.
+   * @param flags Combination of `SLAB_*` flags.
+   * @param slab_size Fixed slab size in bytes, or 0 to pick one based on the object size.
+   * @return `true` if the object fits into a slab; otherwise, `false`.
+   */
+  bool initialize(const char* name, size_t size, size_t align, kmem_ctor_fn ctor,
+                  kmem_ctor_fn dtor, uint32_t flags = 0, size_t slab_size = 0);
+
+  /// @brief Allocates one object, or returns `nullptr` if no memory is left.
+  void* allocate();
+
+  /// @brief Returns an object obtained from `allocate` to the cache.
+  void free(void* object);
+
+  /**
+   * @brief Returns the depot and the magazines of the calling CPU to the slabs, then releases all
+   * empty slabs back to the page allocator.
+   * @return Number of bytes released.
+   */
+  size_t shrink();
+
+  /**
+   * @brief Returns the magazines of every CPU and the depot to the slabs.
+   * @warning Only safe once no other CPU uses the cache anymore.
+   */
+  void drain_all();
+
+  /// @brief Logs usage statistics of the cache.
+  void info() const;
+
+  const char* name() const { return this->m_name; }
+  size_t object_size() const { return this->m_object_size; }
+  size_t active_objects() const { return this->m_active_objects; }
+
+ private:
+  void* slab_allocate();
+  void slab_free(void* object);
+
+  Magazine* exchange_full(SlabCpuCache& cpu);
+  Magazine* exchange_empty(SlabCpuCache& cpu);
+  void drain_magazine(Magazine* magazine);
+  void drain_cpu(SlabCpuCache& cpu);
+  void drain_depot();
+
+  Slab* grow();
+  void release(Slab* slab);
+  void*& next_free(void* object) const;
+
+  const char* m_name = nullptr;
+  kmem_ctor_fn m_ctor = nullptr;
+  kmem_ctor_fn m_dtor = nullptr;
+
+  size_t m_object_size = 0;       ///< Size requested by the user.
+  size_t m_stride = 0;            ///< Distance between two objects in a slab.
+  size_t m_align = 0;             ///< Object alignment.
+  size_t m_link_offset = 0;       ///< Offset of the free list link inside a free object.
+  size_t m_slab_size = 0;         ///< Size of a slab in bytes.
+  size_t m_first_offset = 0;      ///< Offset of the first object, without coloring.
+  size_t m_objects_per_slab = 0;  ///< Number of objects that fit into a slab.
+  size_t m_color_step = 0;        ///< Granularity of the coloring offset.
+  size_t m_color_max = 0;         ///< Largest coloring offset that still fits.
+  size_t m_color_next = 0;        ///< Coloring offset of the next slab.
+
+  size_t m_active_objects = 0;  ///< Objects handed out by the slabs, including magazine rounds.
+  size_t m_total_slabs = 0;     ///< Slabs currently owned by the cache.
+  bool m_magazines = false;     ///< Whether the per-CPU magazine layer is used.
+
+  List<Slab> m_full;
+  List<Slab> m_partial;
+  List<Slab> m_empty;
+
+  TicketLock m_lock;
+
+  List<Magazine> m_depot_full;   ///< Full magazines available to any CPU.
+  List<Magazine> m_depot_empty;  ///< Empty magazines available to any CPU.
+  TicketLock m_depot_lock;
+
+  SlabCpuCache m_cpu[MAX_CPUS];
+};
+
+/**
+ * @brief Creates a new object cache.
+ * @return The cache, or `nullptr` if the object cannot fit into a slab.
+ */
+SlabCache* kmem_cache_create(const char* name, size_t size, size_t align, kmem_ctor_fn ctor,
+                             kmem_ctor_fn dtor);
+
+/**
+ * @brief Destroys an object cache. All of its objects must have been freed.
+ */
+void kmem_cache_destroy(SlabCache* cache);
+
+/// @brief Allocates an object from the given cache.
+void* kmem_cache_alloc(SlabCache* cache);
+
+/// @brief Returns an object to the cache it was allocated from.
+void kmem_cache_free(SlabCache* cache, void* object);
+
+/**
+ * @brief Releases the empty slabs of a single cache.
+ * @return Number of bytes released.
+ */
+size_t kmem_cache_shrink(SlabCache* cache);
+
+/**
+ * @brief Releases the empty slabs of every cache.
+ * @return Number of bytes released.
+ */
+size_t kmem_reap();
+
+/**
+ * @brief Allocates `size` bytes from the kernel heap.
+ *
+ * @details Allocations up to `KMALLOC_MAX_SIZE` are naturally aligned to their size class. Larger
+ * allocations are aligned to a cache line.
+ */
+void* kmalloc(size_t size) __MALLOC __ALLOC_SIZE(1);
+
+/**
+ * @brief Allocates `size` bytes aligned to at least `align` bytes from the kernel heap.
+ * @return The allocation, or `nullptr` if `align` is not a power of two below `KMALLOC_SLAB_SIZE`.
+ */
+void* kmalloc_aligned(size_t size, size_t align) __MALLOC __ALLOC_SIZE(1);
+
+/**
+ * @brief Allocates like `kmalloc_aligned`, attributing the allocation to `caller`.
+ *
+ * @details Lets wrappers around the heap, such as `operator new`, report their own caller to the
+ * allocation profiler. Without the profiler, `caller` is ignored.
+ */
+void* kmalloc_caller(size_t size, size_t align, void* caller) __MALLOC __ALLOC_SIZE(1);
+
+/// @brief Frees memory obtained from `kmalloc`. Passing `nullptr` is a no-op.
+void kfree(void* ptr);
+
+/// @brief Sets up the kmalloc size classes. Requires the physical allocator.
+void kmem_initialize();
+
+/// @brief Logs usage statistics of every cache.
+void kmem_info();
+
+#endif  // KERNEL_MEMORY_SLAB_HPP
\ No newline at end of file
@@ -0,0 +1,207 @@
+/**
+ * @file
+ * @brief Provides kernel threads, cooperatively scheduled on the processor they were started on.
+ *
+ * Every thread has a stack of its own in the kernel stack region, below which an unmapped guard
+ * page turns an overflow into a page fault on the double fault stack instead of silent corruption
+ * of the neighbouring stack. Stacks are recycled without being unmapped, so ending a thread never
+ * needs a TLB shootdown.
+ *
+ * Every processor has a run queue of ready threads and an idle thread, which is the context that
+ * initialized the processor and runs its idle loop. The idle thread is never queued, it runs when
+ * no other thread is ready. Threads run until they yield, block or exit; a switch saves only the
+ * callee-saved registers, see `context_switch`, and charges the cycles since the previous switch
+ * to the thread that ran.
+ *
+ * The FS base of a processor points at its running thread, so thread-local data is a field of
+ * `Thread` read with a single `%fs` relative load, like `this_cpu_read` does for the per-CPU
+ * block. The scheduler itself finds the running thread through the per-CPU block.
+ *
+ * Key components:
+ * - `Thread`: A kernel thread and its thread-local data.
+ * - `thread_create` / `thread_start`: Create a thread and queue it on a processor.
+ * - `thread_yield` / `thread_block` / `thread_wake` / `thread_exit`: Scheduling operations.
+ * - `thread_fpu_initialize`: Gives the running thread the FPU state it needs in user mode.
+ * - `this_thread` / `this_thread_read` / `this_thread_write`: Access the running thread.
+ * - `thread_benchmark_run`: Measures the round trip of two switches, when the kernel is configured
+ *   with `-Denable-benchmarks=true`.
+ *
+ * @note User mode can reload `%fs`, which clears the FS base. Code reached from user mode, and the
+ * idle thread after `user_enter` returned, must not use the accessors until the next switch.
+ */
+#ifndef KERNEL_SCHED_THREAD_HPP
+#define KERNEL_SCHED_THREAD_HPP 1
+
+#include <compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel/arch/x86_64/cpu/fpu.hpp>
+
+#define THREAD_STACK_REGION 0xffffff0000000000ul  ///< Start of the kernel stack region.
+#define THREAD_STACK_SIZE 0x4000                  ///< Usable size of a thread stack.
+#define THREAD_GUARD_SIZE 0x1000                  ///< Unmapped guard below every stack.
+#define THREAD_MAX_STACKS 1024                    ///< Stacks the region holds.
+
+#define THREAD_BENCHMARK_ITERATIONS 100000  ///< Round trips per benchmark run.
+
+/// @brief Function run by a thread.
+using ThreadFunction = void (*)(void* arg);
+
+/**
+ * @brief Scheduling state of a thread.
+ */
+enum ThreadState : uint32_t {
+  THREAD_READY,    ///< Queued, or the idle thread while another thread runs.
+  THREAD_RUNNING,  ///< Running on its processor.
+  THREAD_BLOCKED,  ///< Waiting for `thread_wake`.
+  THREAD_DEAD,     ///< Exited, freed by the next thread that runs on its processor.
+};
+
+/**
+ * @brief A kernel thread.
+ *
+ * @details `self` is read through the FS base and must stay the first field.
+ */
+struct Thread {
+  Thread* self = nullptr;             ///< Address of this thread.
+  uintptr_t stack_pointer = 0;        ///< Saved stack pointer while the thread does not run.
+  ThreadFunction function = nullptr;  ///< Function the thread runs.
+  void* arg = nullptr;                ///< Argument of `function`.
+  FpuState* fpu = nullptr;            ///< FPU state, `nullptr` for threads that stay in the kernel.
+  FpuState fpu_state;                 ///< Storage of `fpu`, see `thread_fpu_initialize`.
+
+  uint32_t cpu = 0;                  ///< Index of the processor the thread runs on.
+  ThreadState state = THREAD_READY;  ///< Scheduling state, changed under the run queue lock.
+  bool wake_pending = false;         ///< A wakeup arrived while the thread was not blocked.
+  uint32_t stack_slot = 0;           ///< Slot of the stack in the region.
+
+  uint64_t run_cycles = 0;  ///< TSC cycles the thread ran, up to its last switch away.
+  uint64_t switches = 0;    ///< Times the thread was switched to.
+
+  Thread* next = nullptr;  ///< Next thread in the run queue.
+  const char* name = "";   ///< Name for diagnostics.
+};
+
+/**
+ * @brief Makes the executing context the idle thread of the executing processor.
+ * @details Must be called on every processor after its per-CPU block was installed and the FPU was
+ * initialized.
+ */
+void thread_cpu_initialize();
+
+/**
+ * @brief Creates a thread that runs `function(arg)`, it does not run before `thread_start`.
+ * @details Returning from `function` exits the thread. Must be called after the physical memory
+ * allocator was initialized.
+ * @return `nullptr` if no stack or memory is left.
+ */
+Thread* thread_create(ThreadFunction function, void* arg, const char* name);
+
+/**
+ * @brief Queues the created `thread` on the processor with index `cpu`, where it stays.
+ */
+void thread_start(Thread* thread, uint32_t cpu);
+
+/**
+ * @brief Lets the next ready thread of the executing processor run.
+ * @details Returns immediately if no other thread is ready. Must be called with interrupts enabled
+ * and outside of any lock, from a thread or from the idle loop.
+ */
+void thread_yield();
+
+/**
+ * @brief Stops the running thread until `thread_wake`.
+ * @details Returns immediately, consuming it, if a wakeup arrived since the thread last blocked,
+ * so a wakeup between checking a condition and blocking is not lost. Callers recheck their
+ * condition after it returned. Must not be called from the idle thread.
+ */
+void thread_block();
+
+/**
+ * @brief Makes a blocked `thread` ready, or lets its next `thread_block` return.
+ * @details Can be called from any processor and from interrupt handlers.
+ */
+void thread_wake(Thread* thread);
+
+/**
+ * @brief Ends the running thread, its stack and `Thread` are freed after the switch away.
+ */
+__NO_RETURN void thread_exit();
+
+/**
+ * @brief Gives the running thread an FPU state, which it needs before it enters user mode.
+ * @details Does nothing if the thread already has one, it is freed when the thread is. Requires
+ * the kernel heap.
+ * @return `false` if the state could not be allocated.
+ */
+bool thread_fpu_initialize();
+
+/// @brief Returns whether a thread is queued on the executing processor.
+bool thread_ready();
+
+/**
+ * @brief Returns the thread running on the executing processor.
+ */
+inline Thread* this_thread() {
+  Thread* thread;
+  asm volatile("movq %%fs:%c1, %0" : "=r"(thread) : "i"(offsetof(Thread, self)));
+  return thread;
+}
+
+/**
+ * @brief Reads the field at `Offset` of the running thread with one `%fs` load.
+ */
+template <typename T, size_t Offset>
+  requires(sizeof(T) == 4 || sizeof(T) == 8)
+T thread_local_read() {
+  T value;
+
+  if constexpr (sizeof(T) == 4) {
+    asm volatile("movl %%fs:%c1, %0" : "=r"(value) : "i"(Offset));
+  } else {
+    asm volatile("movq %%fs:%c1, %0" : "=r"(value) : "i"(Offset));
+  }
+
+  return value;
+}
+
+/**
+ * @brief Writes the field at `Offset` of the running thread with one `%fs` store.
+ */
+template <typename T, size_t Offset>
+  requires(sizeof(T) == 4 || sizeof(T) == 8)
+void thread_local_write(T value) {
+  if constexpr (sizeof(T) == 4) {
+    asm volatile("movl %0, %%fs:%c1" ::"r"(value), "i"(Offset) : "memory");
+  } else {
+    asm volatile("movq %0, %%fs:%c1" ::"r"(value), "i"(Offset) : "memory");
+  }
+}
+
+/// @brief Reads `field` of the running thread.
+#define this_thread_read(field) \
+  thread_local_read<decltype(Thread::field), offsetof(Thread, field)>()
+
+/// @brief Writes `value` to `field` of the running thread.
+#define this_thread_write(field, value) \
+  thread_local_write<decltype(Thread::field), offsetof(Thread, field)>(value)
+
+#ifdef ENABLE_BENCHMARKS
+
+/**
+ * @brief Measures the cost of a round trip between two threads on the executing processor and
+ * logs it.
+ * @details Must be called from the idle thread, after the physical memory allocator was
+ * initialized.
+ */
+void thread_benchmark_run();
+
+#else
+
+inline void thread_benchmark_run() {}
+
+#endif  // ENABLE_BENCHMARKS
+
+#endif  // KERNEL_SCHED_THREAD_HPP
\ No newline at end of file
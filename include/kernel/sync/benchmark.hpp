@@ -0,0 +1,35 @@
+/**
+ * @file
+ * @brief Provides optional micro-benchmarks of the synchronization primitives.
+ *
+ * When the kernel is configured with `-Denable-benchmarks=true`, `sync_benchmark_run` measures the
+ * exclusive locks under contention and the read sides of the reader-writer primitives on 1, 2, 4,
+ * ... up to all online processors, and logs the average cost of a section in timestamp counter
+ * cycles. Run the kernel with `-Dqemu-cpus=N` to choose the
+ * number of processors.
+ *
+ * Without the option the benchmarks are not part of the build and `sync_benchmark_run` does
+ * nothing.
+ */
+#ifndef KERNEL_SYNC_BENCHMARK_HPP
+#define KERNEL_SYNC_BENCHMARK_HPP 1
+
+#include <cstddef>
+
+#define SYNC_BENCHMARK_ITERATIONS 100000  ///< Sections per processor and run.
+
+#ifdef ENABLE_BENCHMARKS
+
+/**
+ * @brief Runs all synchronization benchmarks and logs their results.
+ * @details Must be called after `arch_smp_initialize`.
+ */
+void sync_benchmark_run();
+
+#else
+
+inline void sync_benchmark_run() {}
+
+#endif  // ENABLE_BENCHMARKS
+
+#endif  // KERNEL_SYNC_BENCHMARK_HPP
\ No newline at end of file
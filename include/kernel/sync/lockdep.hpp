@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @brief Provides lock validation for debug builds.
+ *
+ * In debug builds the lock guards report every acquisition and release. The validator keeps a
+ * stack of held locks per processor and a table of every lock order observed so far, and reports:
+ * - Acquiring a lock the processor already holds, which would deadlock.
+ * - Acquiring two locks in the opposite order of an earlier acquisition, which can deadlock once
+ *   both orders happen concurrently.
+ * - Holding a lock for longer than `LOCKDEP_HOLD_LIMIT_CYCLES`, which delays every waiter and,
+ *   with interrupts disabled, the interrupts of the holder.
+ *
+ * Locks are identified by their address, acquisitions by their acquire site, see `lock_site`. In
+ * release builds all hooks expand to nothing.
+ */
+#ifndef KERNEL_SYNC_LOCKDEP_HPP
+#define KERNEL_SYNC_LOCKDEP_HPP 1
+
+#include <compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#define LOCKDEP_MAX_HELD 16                    ///< Held locks tracked per processor.
+#define LOCKDEP_MAX_ORDERS 1024                ///< Size of the lock order table, a power of two.
+#define LOCKDEP_HOLD_LIMIT_CYCLES (1ul << 26)  ///< Hold time in cycles that triggers a warning.
+
+/**
+ * @brief Returns the address of the code evaluating the call, the acquire site of a lock.
+ *
+ * @details The lock guards take it as a default argument, which is evaluated in the function that
+ * constructs the guard, and it is always inlined there. `__builtin_return_address` inside the
+ * guard constructors would instead name the caller of that function once they are inlined.
+ */
+__ALWAYS_INLINE inline const void* lock_site() {
+  const void* site;
+  asm volatile("leaq 0(%%rip), %0" : "=r"(site));
+  return site;
+}
+
+#ifdef DEBUG
+
+/**
+ * @brief Validates an acquisition of `lock` before the caller starts waiting for it.
+ * @param lock Address of the lock.
+ * @param site Acquire site, see `lock_site`.
+ */
+void lockdep_check(const void* lock, const void* site);
+
+/**
+ * @brief Records that `lock` is now held by the executing processor.
+ */
+void lockdep_acquire(const void* lock, const void* site);
+
+/**
+ * @brief Records that `lock` was released and reports overly long hold times.
+ */
+void lockdep_release(const void* lock);
+
+#else
+
+#define lockdep_check(lock, site) WRAP_MACRO()
+#define lockdep_acquire(lock, site) WRAP_MACRO()
+#define lockdep_release(lock) WRAP_MACRO()
+
+#endif  // DEBUG
+
+#endif  // KERNEL_SYNC_LOCKDEP_HPP
\ No newline at end of file
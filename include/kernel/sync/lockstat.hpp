@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Provides optional lock contention statistics.
+ *
+ * When the kernel is configured with `-Denable-lockstat=true`, the lock guards first try to take
+ * their lock without waiting and only fall back to a waiting acquisition if that fails. Every
+ * acquisition is recorded per lock class with:
+ * - The number of acquisitions and of contended acquisitions, those that had to wait.
+ * - The total and maximum time spent waiting, in timestamp counter cycles.
+ * - The maximum time the lock was held, in timestamp counter cycles.
+ *
+ * A lock class is the acquire site, the code address of the guard construction captured by
+ * `lock_site`, so all locks taken at the same place, e.g. the locks of every slab cache, are
+ * accounted together. The dump lists sites as kernel addresses, `addr2line -f -e kernel` resolves
+ * them to functions and lines. Each processor records into its own table, so
+ * the statistics add no shared cache line writes of their own; `lockstat_dump` merges the tables.
+ *
+ * Without the option the hooks expand to the plain acquisition and release, the guards carry no
+ * extra state and the statistics are not part of the build.
+ *
+ * Key components:
+ * - `lockstat_lock` / `lockstat_unlock`: Hooks placed in the lock guards.
+ * - `lockstat_dump`: Logs the lock classes with the most total wait time.
+ */
+#ifndef KERNEL_SYNC_LOCKSTAT_HPP
+#define KERNEL_SYNC_LOCKSTAT_HPP 1
+
+#include <compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#define LOCKSTAT_CLASSES 256     ///< Lock classes tracked per processor, a power of two.
+#define LOCKSTAT_DEFAULT_TOP 10  ///< Lock classes listed by default.
+
+#ifdef ENABLE_LOCKSTAT
+
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+
+struct LockClassStat;
+
+/**
+ * @brief State of one acquisition, kept by the guard until the lock is released.
+ */
+struct LockStatSample {
+  LockClassStat* stat;  ///< Statistics of the lock class, `nullptr` if the table was full.
+  uint64_t acquired;    ///< Timestamp of the acquisition.
+};
+
+/**
+ * @brief Records an acquisition.
+ *
+ * @param sample Filled with the state needed by `lockstat_released`.
+ * @param site Acquire site, see `lock_site`.
+ * @param start Timestamp taken before the first acquisition attempt.
+ * @param contended Whether the first attempt failed and the caller had to wait.
+ */
+void lockstat_acquired(LockStatSample& sample, const void* site, uint64_t start, bool contended);
+
+/**
+ * @brief Records the hold time of an acquisition that is about to be released.
+ */
+void lockstat_released(const LockStatSample& sample);
+
+/**
+ * @brief Logs the lock classes with the most total wait time of all processors.
+ * @param top Number of lock classes to list.
+ */
+void lockstat_dump(size_t top = LOCKSTAT_DEFAULT_TOP);
+
+#define lockstat_lock(sample, site, try_acquire, acquire)                    \
+  do {                                                                       \
+    const uint64_t lockstat_start = rdtsc();                                 \
+    const bool lockstat_contended = !(try_acquire);                          \
+                                                                             \
+    if (lockstat_contended) {                                                \
+      acquire;                                                               \
+    }                                                                        \
+                                                                             \
+    lockstat_acquired((sample), (site), lockstat_start, lockstat_contended); \
+  } while (0)
+#define lockstat_unlock(sample) lockstat_released(sample)
+
+#else
+
+struct LockStatSample {};
+
+#define lockstat_lock(sample, site, try_acquire, acquire) WRAP_MACRO(acquire)
+#define lockstat_unlock(sample) WRAP_MACRO()
+
+inline void lockstat_dump(size_t = LOCKSTAT_DEFAULT_TOP) {}
+
+#endif  // ENABLE_LOCKSTAT
+
+#endif  // KERNEL_SYNC_LOCKSTAT_HPP
\ No newline at end of file
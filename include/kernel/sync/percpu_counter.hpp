@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Provides statistics counters that are updated without shared cache line writes.
+ *
+ * A plain shared counter bounces its cache line between all processors that update it. A per-CPU
+ * counter lets every processor accumulate changes in its own cache line and only folds them into
+ * the shared total once they reach a batch size, so most updates touch processor-local memory.
+ *
+ * Reads come in two flavours:
+ * - `read`: Returns the shared total only. Cheap, but off by up to `Batch - 1` per processor.
+ * - `sum`: Adds the pending changes of every processor. Exact while no update runs concurrently,
+ *   but visits `MAX_CPUS` cache lines.
+ *
+ * Key components:
+ * - `PercpuCounter`: The counter.
+ *
+ * @note Every counter takes `MAX_CPUS + 1` cache lines. Use it for hot statistics, not for every
+ * value that is occasionally counted.
+ */
+#ifndef KERNEL_SYNC_PERCPU_COUNTER_HPP
+#define KERNEL_SYNC_PERCPU_COUNTER_HPP 1
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include <kernel/arch/arch.hpp>
+
+#define PERCPU_COUNTER_BATCH 32  ///< Default change a processor accumulates before folding it.
+
+/**
+ * @brief Counter with processor-local updates and lazily aggregated reads.
+ *
+ * @details Changes are kept per processor as signed deltas, so a value that is incremented on one
+ * processor and decremented on another works as expected.
+ */
+template <typename T = int64_t, T Batch = PERCPU_COUNTER_BATCH>
+  requires(std::is_integral_v<T> && std::is_signed_v<T> && Batch > 0)
+class PercpuCounter {
+ public:
+  constexpr PercpuCounter() = default;
+
+  PercpuCounter(const PercpuCounter&) = delete;
+  PercpuCounter& operator=(const PercpuCounter&) = delete;
+
+  /**
+   * @brief Adds `delta` to the counter.
+   * @details Only the local delta is written unless it reaches `Batch` in either direction.
+   */
+  void add(T delta) {
+    const uint64_t flags = arch_interrupt_save();
+    std::atomic<T>& local = this->m_deltas[arch_cpu_index()].value;
+    const T value = local.load(std::memory_order_relaxed) + delta;
+
+    if (value >= Batch || value <= -Batch) {
+      local.store(0, std::memory_order_relaxed);
+      this->m_total.fetch_add(value, std::memory_order_relaxed);
+    } else {
+      local.store(value, std::memory_order_relaxed);
+    }
+
+    arch_interrupt_restore(flags);
+  }
+
+  void increment() { this->add(1); }
+  void decrement() { this->add(-1); }
+
+  /**
+   * @brief Returns the folded total, without the changes still pending on each processor.
+   */
+  T read() const { return this->m_total.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Returns the folded total plus the pending changes of every processor.
+   */
+  T sum() const {
+    T value = this->m_total.load(std::memory_order_relaxed);
+
+    for (const auto& delta : this->m_deltas) {
+      value += delta.value.load(std::memory_order_relaxed);
+    }
+
+    return value;
+  }
+
+ private:
+  struct alignas(CACHE_LINE_SIZE) Delta {
+    std::atomic<T> value = 0;
+  };
+
+  Delta m_deltas[MAX_CPUS];
+  alignas(CACHE_LINE_SIZE) std::atomic<T> m_total = 0;
+};
+
+#endif  // KERNEL_SYNC_PERCPU_COUNTER_HPP
\ No newline at end of file
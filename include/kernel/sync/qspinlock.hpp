@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @brief Provides a queued spinlock that keeps waiters spinning on their own cache line.
+ *
+ * With a `TicketLock` every waiter polls the same word, so each hand-off invalidates the cache line
+ * in every waiting processor. The queued spinlock combines a 4 byte lock word with an MCS queue of
+ * per-CPU nodes: an uncontended acquisition is a single compare-and-swap of the word, while
+ * contended processors append their node to the queue and spin on a flag in that node until their
+ * predecessor hands the lock over. Only the processor at the head of the queue polls the lock word.
+ *
+ * Lock word layout:
+ * - Bits 0-7: Locked byte, non-zero while the lock is held.
+ * - Bits 16-31: Tail of the waiter queue, `(cpu + 1) << 2 | nesting level`, 0 if empty.
+ *
+ * Key components:
+ * - `QueuedSpinLock`: The lock, usable with `LockGuard`.
+ * - `McsNode`: Queue node, `QSPINLOCK_MAX_NESTING` of them per processor.
+ *
+ * @note Holders must not migrate to another processor, i.e. acquire the lock with interrupts or
+ * preemption disabled once either exists.
+ */
+#ifndef KERNEL_SYNC_QSPINLOCK_HPP
+#define KERNEL_SYNC_QSPINLOCK_HPP 1
+
+#include <compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel/arch/arch.hpp>
+
+/**
+ * @brief Queue nodes per processor, one for each context that can spin on a lock at the same
+ * time: thread, software interrupt, hardware interrupt and NMI.
+ */
+#define QSPINLOCK_MAX_NESTING 4
+
+#define QSPINLOCK_LOCKED 1u          ///< Value of the locked byte while the lock is held.
+#define QSPINLOCK_LOCKED_MASK 0xffu  ///< Mask of the locked byte in the lock word.
+#define QSPINLOCK_TAIL_SHIFT 16      ///< Position of the queue tail in the lock word.
+#define QSPINLOCK_TAIL_INDEX_BITS 2  ///< Bits of the tail holding the nesting level.
+
+static_assert(QSPINLOCK_MAX_NESTING <= (1 << QSPINLOCK_TAIL_INDEX_BITS));
+static_assert(MAX_CPUS < (1 << (16 - QSPINLOCK_TAIL_INDEX_BITS)));
+
+/**
+ * @brief Node of the waiter queue, owned by one processor and nesting level.
+ */
+struct alignas(CACHE_LINE_SIZE) McsNode {
+  McsNode* next;   ///< Next waiter, set by the successor after it queued.
+  uint32_t ready;  ///< Set by the predecessor when this node becomes the head of the queue.
+  uint32_t count;  ///< Nodes of the processor in use, only maintained in the first node.
+};
+
+/**
+ * @brief Spinlock with a compare-and-swap fast path and an MCS queue for contended acquisitions.
+ */
+class QueuedSpinLock {
+ public:
+  constexpr QueuedSpinLock() = default;
+
+  QueuedSpinLock(const QueuedSpinLock&) = delete;
+  QueuedSpinLock& operator=(const QueuedSpinLock&) = delete;
+
+  /**
+   * @brief Acquires the lock, queueing behind other waiters if it is held.
+   */
+  void lock() {
+    uint32_t expected = 0;
+
+    if (likely(__atomic_compare_exchange_n(&this->m_word.value, &expected, QSPINLOCK_LOCKED,
+                                           false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))) {
+      return;
+    }
+
+    this->lock_slow();
+  }
+
+  /**
+   * @brief Releases the lock.
+   *
+   * @details Only the holder writes the locked byte, so a plain release store suffices and no
+   * locked instruction is needed.
+   */
+  void unlock() { __atomic_store_n(&this->m_word.parts.locked, 0, __ATOMIC_RELEASE); }
+
+  /**
+   * @brief Attempts to acquire the lock without waiting.
+   * @return `true` if the lock was acquired.
+   */
+  bool try_lock() {
+    uint32_t expected = 0;
+
+    return __atomic_compare_exchange_n(&this->m_word.value, &expected, QSPINLOCK_LOCKED, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+  }
+
+  /// @brief Checks whether the lock is currently held.
+  bool is_locked() const {
+    return __atomic_load_n(&this->m_word.value, __ATOMIC_RELAXED) & QSPINLOCK_LOCKED_MASK;
+  }
+
+ private:
+  union Word {
+    uint32_t value;
+
+    struct {
+      uint8_t locked;    ///< Non-zero while the lock is held.
+      uint8_t reserved;  ///< Unused.
+      uint16_t tail;     ///< Encoded last node of the waiter queue.
+    } parts;
+  };
+
+  __NO_INLINE void lock_slow();
+
+  Word m_word = {0};
+};
+
+#endif  // KERNEL_SYNC_QSPINLOCK_HPP
\ No newline at end of file
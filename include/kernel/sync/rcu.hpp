@@ -0,0 +1,129 @@
+/**
+ * @file
+ * @brief Provides quiescent-state-based read-copy-update (RCU).
+ *
+ * RCU lets readers traverse shared data without locks and without writing shared memory. Writers
+ * publish a modified copy with `rcu_assign_pointer` and free the old version only after a grace
+ * period: once every processor passed through a quiescent state, no reader can still hold a
+ * reference obtained before the update.
+ *
+ * Read sections must not block or be preempted, so a processor is quiescent whenever it is outside
+ * of one. Quiescent states are reported by the idle loops, at context switches and by
+ * `synchronize_rcu` itself. Halted processors are in an extended quiescent state and do not hold up
+ * grace periods at all. Therefore `rcu_read_lock` and `rcu_read_unlock` are only compiler barriers.
+ *
+ * Callbacks queued with `call_rcu` are batched per processor: all callbacks queued before a grace
+ * period was requested wait for the same grace period and run together afterwards, on the
+ * processor that queued them.
+ *
+ * Key components:
+ * - `rcu_read_lock` / `rcu_read_unlock` / `RcuReadGuard`: Mark a read section.
+ * - `rcu_dereference` / `rcu_assign_pointer`: Read and publish RCU protected pointers.
+ * - `synchronize_rcu`: Waits for a grace period.
+ * - `call_rcu`: Runs a callback after a grace period without waiting.
+ * - `rcu_quiescent`, `rcu_idle_enter` / `rcu_idle_exit`: Hooks of the scheduler and idle loops.
+ * - `rcu_irq_enter` / `rcu_irq_exit`: Hooks of the interrupt exit path around software interrupts.
+ *
+ * Software interrupts that run on the way out of an interrupt that woke an idle processor leave
+ * the extended quiescent state for as long as they run, so timer callbacks, tasklets and other
+ * software interrupt handlers are ordinary readers.
+ *
+ * @note Hard interrupt handlers that run while their processor is halted are not covered and must
+ * not read RCU protected data; they can defer such work to a software interrupt.
+ */
+#ifndef KERNEL_SYNC_RCU_HPP
+#define KERNEL_SYNC_RCU_HPP 1
+
+#include <cstdint>
+
+struct RcuHead;
+
+/// @brief Function run after a grace period, usually frees the object containing `head`.
+using RcuCallback = void (*)(RcuHead* head);
+
+/**
+ * @brief Callback list entry, embedded in the object to be reclaimed.
+ */
+struct RcuHead {
+  RcuHead* next;         ///< Next queued callback.
+  RcuCallback callback;  ///< Function to run after the grace period.
+};
+
+/// @brief Marks the beginning of a read section.
+inline void rcu_read_lock() { asm volatile("" ::: "memory"); }
+
+/// @brief Marks the end of a read section.
+inline void rcu_read_unlock() { asm volatile("" ::: "memory"); }
+
+/**
+ * @brief Loads an RCU protected pointer inside a read section.
+ * @details An acquire load, which is a plain move on x86.
+ */
+template <typename T>
+T* rcu_dereference(T* const& pointer) {
+  return __atomic_load_n(&pointer, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Publishes a new version of RCU protected data.
+ * @details The release store orders the initialization of `value` before its publication.
+ */
+template <typename T>
+void rcu_assign_pointer(T*& pointer, T* value) {
+  __atomic_store_n(&pointer, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Waits until every read section that started before the call has ended.
+ * @note Must not be called inside a read section.
+ */
+void synchronize_rcu();
+
+/**
+ * @brief Queues `callback(head)` to run once every current read section has ended.
+ */
+void call_rcu(RcuHead* head, RcuCallback callback);
+
+/**
+ * @brief Reports a quiescent state of the executing processor and runs its expired callbacks.
+ * @details Called from idle loops and at context switches.
+ */
+void rcu_quiescent();
+
+/**
+ * @brief Enters the extended quiescent state before the processor halts.
+ */
+void rcu_idle_enter();
+
+/**
+ * @brief Leaves the extended quiescent state after the processor woke up.
+ */
+void rcu_idle_exit();
+
+/**
+ * @brief Leaves the extended quiescent state, if the processor is in it, before code of an
+ * interrupt reads RCU protected data.
+ * @details Must be called with interrupts disabled.
+ * @return Whether the processor was idle, to be passed to `rcu_irq_exit`.
+ */
+bool rcu_irq_enter();
+
+/**
+ * @brief Returns to the extended quiescent state if `idle`, the result of `rcu_irq_enter`.
+ * @details Must be called with interrupts disabled and outside of any read section.
+ */
+void rcu_irq_exit(bool idle);
+
+/**
+ * @brief Marks a read section for the lifetime of a scope.
+ */
+class RcuReadGuard {
+ public:
+  RcuReadGuard() { rcu_read_lock(); }
+  ~RcuReadGuard() { rcu_read_unlock(); }
+
+  RcuReadGuard(const RcuReadGuard&) = delete;
+  RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+};
+
+#endif  // KERNEL_SYNC_RCU_HPP
\ No newline at end of file
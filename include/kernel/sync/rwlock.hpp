@@ -0,0 +1,204 @@
+/**
+ * @file
+ * @brief Provides reader-writer spinlocks for read-mostly data.
+ *
+ * Readers of a reader-writer lock run concurrently, writers exclude everyone. Two variants with
+ * different costs are provided:
+ * - `RwSpinLock`: A single 4 byte word. Readers and writers update the same cache line, so readers
+ *   still bounce it between processors, but never wait for each other.
+ * - `PercpuRwLock`: Every processor counts its readers in its own cache line, so a read section
+ *   writes only processor-local memory. Writers have to visit every processor's line and are much
+ *   more expensive, and the lock takes `MAX_CPUS` cache lines. Meant for global tables that are
+ *   read on every processor and almost never written.
+ *
+ * Both variants prefer writers: once a writer waits, new readers hold back until it is done, so a
+ * steady stream of readers cannot starve it.
+ *
+ * Key components:
+ * - `RwSpinLock` / `PercpuRwLock`: The locks.
+ * - `ReadGuard` / `WriteGuard`: Hold a lock for reading or writing for the lifetime of a scope.
+ *
+ * @note A processor must not acquire a lock for reading while it already holds it: with a writer
+ * waiting in between, the inner acquisition waits for the writer and the writer for the outer one.
+ * If interrupt handlers read a lock, all its other readers must disable interrupts.
+ */
+#ifndef KERNEL_SYNC_RWLOCK_HPP
+#define KERNEL_SYNC_RWLOCK_HPP 1
+
+#include <compiler.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/sync/lockdep.hpp>
+#include <kernel/sync/lockstat.hpp>
+#include <kernel/sync/qspinlock.hpp>
+
+#define RWLOCK_WRITER_LOCKED 1u   ///< A writer holds the lock.
+#define RWLOCK_WRITER_WAITING 2u  ///< At least one writer waits for the lock.
+#define RWLOCK_READER 4u          ///< Increment of the reader count.
+
+/**
+ * @brief Writer-preferring reader-writer spinlock in a single word.
+ *
+ * @details The low two bits hold the writer state, the remaining bits count the active readers.
+ */
+class RwSpinLock {
+ public:
+  constexpr RwSpinLock() = default;
+
+  RwSpinLock(const RwSpinLock&) = delete;
+  RwSpinLock& operator=(const RwSpinLock&) = delete;
+
+  /// @brief Acquires the lock for reading.
+  void read_lock() {
+    const uint32_t state = this->m_state.fetch_add(RWLOCK_READER, std::memory_order_acquire);
+
+    if (unlikely(state & (RWLOCK_WRITER_LOCKED | RWLOCK_WRITER_WAITING))) {
+      this->read_lock_slow();
+    }
+  }
+
+  /// @brief Releases a read acquisition.
+  void read_unlock() { this->m_state.fetch_sub(RWLOCK_READER, std::memory_order_release); }
+
+  /// @brief Acquires the lock for writing.
+  void write_lock() {
+    uint32_t expected = 0;
+
+    if (likely(this->m_state.compare_exchange_strong(expected, RWLOCK_WRITER_LOCKED,
+                                                     std::memory_order_acquire,
+                                                     std::memory_order_relaxed))) {
+      return;
+    }
+
+    this->write_lock_slow();
+  }
+
+  /**
+   * @brief Attempts to acquire the lock for writing without waiting.
+   * @return `true` if the lock was acquired.
+   */
+  bool try_write_lock() {
+    uint32_t expected = 0;
+
+    return this->m_state.compare_exchange_strong(expected, RWLOCK_WRITER_LOCKED,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed);
+  }
+
+  /// @brief Releases a write acquisition, keeping the flag of other waiting writers.
+  void write_unlock() {
+    this->m_state.fetch_and(~RWLOCK_WRITER_LOCKED, std::memory_order_release);
+  }
+
+ private:
+  __NO_INLINE void read_lock_slow();
+  __NO_INLINE void write_lock_slow();
+
+  std::atomic<uint32_t> m_state = 0;
+};
+
+/**
+ * @brief Reader-writer lock with per-CPU reader counts.
+ *
+ * @details A reader increments the counter of the processor it runs on and then checks for a
+ * writer. A writer announces itself and then waits until the counters of all processors add up
+ * to zero. Only the sum matters, so a reader may release the lock on another processor than the
+ * one it acquired it on.
+ */
+class PercpuRwLock {
+ public:
+  constexpr PercpuRwLock() = default;
+
+  PercpuRwLock(const PercpuRwLock&) = delete;
+  PercpuRwLock& operator=(const PercpuRwLock&) = delete;
+
+  /// @brief Acquires the lock for reading.
+  void read_lock() {
+    std::atomic<int32_t>& count = this->m_readers[arch_cpu_index()].count;
+
+    // The increment must be visible before the writer flag is read, hence sequential consistency.
+    count.fetch_add(1, std::memory_order_seq_cst);
+
+    if (unlikely(this->m_writer.load(std::memory_order_seq_cst))) {
+      count.fetch_sub(1, std::memory_order_relaxed);
+      this->read_lock_slow();
+    }
+  }
+
+  /// @brief Releases a read acquisition.
+  void read_unlock() {
+    this->m_readers[arch_cpu_index()].count.fetch_sub(1, std::memory_order_release);
+  }
+
+  /// @brief Acquires the lock for writing.
+  void write_lock();
+
+  /**
+   * @brief Attempts to acquire the lock for writing without waiting.
+   * @return `true` if the lock was acquired, i.e. no writer held it and no reader was active.
+   */
+  bool try_write_lock();
+
+  /// @brief Releases a write acquisition.
+  void write_unlock();
+
+ private:
+  struct alignas(CACHE_LINE_SIZE) ReaderCount {
+    std::atomic<int32_t> count = 0;
+  };
+
+  __NO_INLINE void read_lock_slow();
+
+  ReaderCount m_readers[MAX_CPUS];
+  alignas(CACHE_LINE_SIZE) std::atomic<bool> m_writer = false;
+  QueuedSpinLock m_writer_lock;  ///< Serializes writers.
+};
+
+/**
+ * @brief Holds a reader-writer lock for reading for the lifetime of a scope.
+ */
+template <typename Lock>
+class ReadGuard {
+ public:
+  explicit ReadGuard(Lock& lock) : m_lock(lock) { this->m_lock.read_lock(); }
+  ~ReadGuard() { this->m_lock.read_unlock(); }
+
+  ReadGuard(const ReadGuard&) = delete;
+  ReadGuard& operator=(const ReadGuard&) = delete;
+
+ private:
+  Lock& m_lock;
+};
+
+/**
+ * @brief Holds a reader-writer lock for writing for the lifetime of a scope.
+ * @details Write acquisitions are validated in debug builds and counted by the lock statistics
+ * like those of `LockGuard`.
+ */
+template <typename Lock>
+class WriteGuard {
+ public:
+  explicit WriteGuard(Lock& lock, const void* site = lock_site()) : m_lock(lock) {
+    lockdep_check(&this->m_lock, site);
+    lockstat_lock(this->m_stat, site, this->m_lock.try_write_lock(), this->m_lock.write_lock());
+    lockdep_acquire(&this->m_lock, site);
+  }
+
+  ~WriteGuard() {
+    lockdep_release(&this->m_lock);
+    lockstat_unlock(this->m_stat);
+    this->m_lock.write_unlock();
+  }
+
+  WriteGuard(const WriteGuard&) = delete;
+  WriteGuard& operator=(const WriteGuard&) = delete;
+
+ private:
+  Lock& m_lock;
+  [[no_unique_address]] LockStatSample m_stat;  ///< Empty unless lock statistics are enabled.
+};
+
+#endif  // KERNEL_SYNC_RWLOCK_HPP
\ No newline at end of file
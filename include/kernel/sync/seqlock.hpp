@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @brief Provides sequence locks for small, frequently read records.
+ *
+ * A sequence lock lets readers run without writing any shared memory at all. The writer increments
+ * a sequence counter before and after every update, so the counter is odd while an update is in
+ * progress. A reader samples the counter, copies the data and samples the counter again; if the
+ * counter was odd or changed in between, the copy may be torn and the reader retries.
+ *
+ * Key components:
+ * - `SeqLock`: The sequence counter and a lock serializing writers.
+ * - `SeqLocked`: A value of a trivially copyable type protected by a `SeqLock`.
+ *
+ * @note Readers may see data that is being modified and must not follow pointers read inside the
+ * section before it was validated. A writer must not be interrupted by a reader of the same lock
+ * on its own processor, or the reader spins forever; writers of data read in interrupt handlers
+ * have to disable interrupts.
+ */
+#ifndef KERNEL_SYNC_SEQLOCK_HPP
+#define KERNEL_SYNC_SEQLOCK_HPP 1
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/sync/qspinlock.hpp>
+
+/**
+ * @brief Sequence counter with a writer lock.
+ */
+class SeqLock {
+ public:
+  constexpr SeqLock() = default;
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  /**
+   * @brief Starts a read section, waiting while an update is in progress.
+   * @return Sequence number to pass to `read_retry`.
+   */
+  uint32_t read_begin() const {
+    uint32_t sequence;
+
+    while ((sequence = this->m_sequence.load(std::memory_order_acquire)) & 1) {
+      arch_pause();
+    }
+
+    return sequence;
+  }
+
+  /**
+   * @brief Ends a read section.
+   * @return `true` if a writer interfered and the section has to be repeated.
+   */
+  bool read_retry(uint32_t sequence) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return this->m_sequence.load(std::memory_order_relaxed) != sequence;
+  }
+
+  /// @brief Starts an update, excluding other writers.
+  void write_lock() {
+    this->m_lock.lock();
+    this->m_sequence.store(this->m_sequence.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /// @brief Publishes an update and admits the next writer.
+  void write_unlock() {
+    this->m_sequence.store(this->m_sequence.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_release);
+    this->m_lock.unlock();
+  }
+
+ private:
+  std::atomic<uint32_t> m_sequence = 0;
+  QueuedSpinLock m_lock;
+};
+
+/**
+ * @brief A value that is read through a `SeqLock`.
+ *
+ * @details The value is copied as a whole, so it should be small, e.g. the few fields of a clock.
+ */
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class SeqLocked {
+ public:
+  constexpr SeqLocked() = default;
+  constexpr explicit SeqLocked(const T& value) : m_value(value) {}
+
+  /// @brief Returns a consistent copy of the value.
+  T read() const {
+    T copy;
+    uint32_t sequence;
+
+    do {
+      sequence = this->m_lock.read_begin();
+      __builtin_memcpy(&copy, &this->m_value, sizeof(T));
+    } while (this->m_lock.read_retry(sequence));
+
+    return copy;
+  }
+
+  /// @brief Replaces the value.
+  void write(const T& value) {
+    this->m_lock.write_lock();
+    __builtin_memcpy(&this->m_value, &value, sizeof(T));
+    this->m_lock.write_unlock();
+  }
+
+  /// @brief Modifies the value in place with `update(T&)`.
+  template <typename Update>
+  void update(Update modify) {
+    this->m_lock.write_lock();
+    modify(this->m_value);
+    this->m_lock.write_unlock();
+  }
+
+ private:
+  SeqLock m_lock;
+  T m_value = {};
+};
+
+#endif  // KERNEL_SYNC_SEQLOCK_HPP
\ No newline at end of file
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Provides the monotonic clock of the kernel, based on the time stamp counter (TSC).
+ *
+ * The TSC is read with a single unprivileged instruction and, on processors with an invariant TSC,
+ * ticks at a constant rate in all power states and on all processors. Its frequency is taken from
+ * CPUID when the processor reports it and is measured against the PIT otherwise.
+ *
+ * Conversions between cycles and nanoseconds use a multiplication and a shift instead of a
+ * division, with factors computed once at boot.
+ *
+ * Key components:
+ * - `now_cycles` / `now_ns`: Read the clock in TSC cycles or in nanoseconds since boot.
+ * - `cycles_to_ns` / `ns_to_cycles`: Convert durations.
+ * - `clock_initialize`: Determines the TSC frequency, on the boot processor.
+ * - `clock_sync`: Aligns the TSC of the executing processor with the boot processor.
+ *
+ * @note Conversions and `now_ns` return 0 until `clock_initialize` ran.
+ */
+#ifndef KERNEL_TIME_CLOCK_HPP
+#define KERNEL_TIME_CLOCK_HPP 1
+
+#include <cstdint>
+
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+
+#define CLOCK_SHIFT 32              ///< Fraction bits of the conversion factors.
+#define NS_PER_SECOND 1000000000ul  ///< Nanoseconds per second.
+
+#define CLOCK_CALIBRATION_MS 10   ///< Length of a single PIT calibration run.
+#define CLOCK_CALIBRATION_RUNS 5  ///< PIT calibration runs, the shortest one is used.
+
+/**
+ * @brief Parameters of the clock, written once by `clock_initialize`.
+ */
+struct ClockSource {
+  uint64_t frequency;     ///< TSC frequency in Hz.
+  uint64_t base;          ///< TSC value `now_ns` counts from.
+  uint64_t mult;          ///< Nanoseconds per cycle, scaled by `2^CLOCK_SHIFT`.
+  uint64_t inverse_mult;  ///< Cycles per nanosecond, scaled by `2^CLOCK_SHIFT`.
+};
+
+extern ClockSource clock_source;
+
+/// @brief Returns the current TSC value, the unit of timer deadlines.
+inline uint64_t now_cycles() { return rdtsc(); }
+
+/// @brief Converts a duration in TSC cycles to nanoseconds.
+inline uint64_t cycles_to_ns(uint64_t cycles) {
+  return static_cast<uint64_t>((static_cast<unsigned __int128>(cycles) * clock_source.mult) >>
+                               CLOCK_SHIFT);
+}
+
+/// @brief Converts a duration in nanoseconds to TSC cycles.
+inline uint64_t ns_to_cycles(uint64_t ns) {
+  return static_cast<uint64_t>(
+      (static_cast<unsigned __int128>(ns) * clock_source.inverse_mult) >> CLOCK_SHIFT);
+}
+
+/// @brief Returns the nanoseconds since the clock was initialized.
+inline uint64_t now_ns() { return cycles_to_ns(now_cycles() - clock_source.base); }
+
+/**
+ * @brief Determines the TSC frequency and starts the clock.
+ * @details Must run on the boot processor before the other processors start.
+ */
+void clock_initialize();
+
+/**
+ * @brief Gives the TSC of the executing processor the offset of the boot processor.
+ * @details Firmware may leave different TSC adjustments on each processor. Without the TSC_ADJUST
+ * MSR nothing is done.
+ */
+void clock_sync();
+
+#endif  // KERNEL_TIME_CLOCK_HPP
\ No newline at end of file
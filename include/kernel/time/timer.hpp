@@ -0,0 +1,80 @@
+/**
+ * @file
+ * @brief Provides one-shot timers on top of the local APIC timer.
+ *
+ * Every processor keeps its pending timers in a min-heap ordered by deadline and programs its
+ * local APIC timer for the earliest one only. There is no periodic tick: a processor without
+ * pending timers leaves its timer disarmed and is not woken up while it idles, and a processor
+ * with pending timers is interrupted once per expiry instead of once per tick.
+ *
+ * Deadlines are absolute TSC values as returned by `now_cycles`, so the resolution is a single TSC
+ * cycle when the local APIC supports TSC-deadline mode. Use `ns_to_cycles` for relative timeouts.
+ *
+ * Key components:
+ * - `Timer`: A timer, embedded in the object it belongs to.
+ * - `timer_start`: Arms a timer on the executing processor.
+ * - `timer_cancel`: Disarms a timer from any processor.
+ * - `timer_initialize`: Registers the handler of the local APIC timer interrupt.
+ *
+ * @note Callbacks run from the `SOFTIRQ_TIMER` software interrupt with interrupts enabled, on the
+ * processor that armed the timer.
+ */
+#ifndef KERNEL_TIME_TIMER_HPP
+#define KERNEL_TIME_TIMER_HPP 1
+
+#include <atomic>
+#include <cstdint>
+
+#define TIMER_QUEUE_CAPACITY 256   ///< Pending timers per processor.
+#define TIMER_INACTIVE UINT32_MAX  ///< Heap index of a timer that is not pending.
+
+struct Timer;
+
+/// @brief Function run when `timer` expires.
+using TimerCallback = void (*)(Timer* timer);
+
+/**
+ * @brief One-shot timer.
+ *
+ * @details Only `callback` is set by the owner, the other fields belong to the timer queue. A
+ * callback may restart its own timer.
+ */
+struct Timer {
+  TimerCallback callback;           ///< Function run on expiry.
+  uint64_t deadline = 0;            ///< TSC value the timer expires at.
+  std::atomic<uint32_t> cpu = 0;    ///< Processor whose queue holds the timer.
+  uint32_t index = TIMER_INACTIVE;  ///< Position in the heap, protected by the queue lock.
+};
+
+/**
+ * @brief Arms `timer` to expire once the TSC reaches `deadline`.
+ *
+ * @details A pending timer is cancelled first, so this also moves a timer. The timer expires on
+ * the executing processor. Starting the same timer from two processors at once is not allowed.
+ *
+ * @return `false` if the queue of the executing processor is full.
+ */
+bool timer_start(Timer* timer, uint64_t deadline);
+
+/**
+ * @brief Disarms `timer`.
+ * @return Whether the timer was pending. `false` means it already expired or was never armed, its
+ * callback may still be running on another processor.
+ */
+bool timer_cancel(Timer* timer);
+
+/// @brief Returns whether `timer` waits to expire.
+bool timer_pending(const Timer* timer);
+
+/**
+ * @brief Returns the earliest deadline of the executing processor's timers, 0 if none is pending.
+ */
+uint64_t timer_next_deadline();
+
+/**
+ * @brief Registers the interrupt handlers that run expired timers and re-arm the local APIC timer.
+ * @details Must be called before the first timer is started.
+ */
+void timer_initialize();
+
+#endif  // KERNEL_TIME_TIMER_HPP
\ No newline at end of file
@@ -16,6 +16,7 @@
  * - `TicketLock::unlock`: Releases the lock.
  * - `TicketLock::try_lock`: Attempts to acquire the lock without blocking.
  * - `TicketLock::is_locked`: Checks if the mutex is currently locked.
+ * - `LockGuard`: Holds a lock for the lifetime of a scope, validated in debug builds.
  *
  * @note This implementation uses atomic operations from `<atomic>` to ensure correctness in a
  * concurrent environment.
@@ -27,6 +28,8 @@
 #include <cstddef>
 
 #include <kernel/arch/arch.hpp>
+#include <kernel/sync/lockdep.hpp>
+#include <kernel/sync/lockstat.hpp>
 
 class TicketLock {
  public:
@@ -52,11 +55,11 @@ class TicketLock {
    * @details Increments the `serving_ticket` to allow the next waiting thread to acquire the lock.
    */
   void unlock() {
-    if (this->is_locked()) {
+    if (!this->is_locked()) {
       return;
     }
 
-    this->m_serving_ticket.fetch_add(1, std::memory_order_relaxed);
+    this->m_serving_ticket.fetch_add(1, std::memory_order_release);
   }
 
   /**
@@ -78,17 +81,17 @@ class TicketLock {
    * @brief Attempts to acquire the lock without blocking.
    *
    * @details If the mutex is not locked, it will acquire the lock and return `true`. If the mutex
-   * is already locked, it returns `false` immediately.
+   * is already locked, it returns `false` immediately. The ticket is only taken if it is served
+   * right away, so a failed attempt never leaves the caller queued.
    *
    * @return `true` if the lock was successfully acquired; otherwise, `false`.
    */
   bool try_lock() {
-    if (this->is_locked()) {
-      return false;
-    }
+    size_t ticket = this->m_serving_ticket.load(std::memory_order_acquire);
 
-    this->lock();
-    return true;
+    return this->m_next_ticket.compare_exchange_strong(ticket, ticket + 1,
+                                                       std::memory_order_acquire,
+                                                       std::memory_order_relaxed);
   }
 
  private:
@@ -96,4 +99,35 @@ class TicketLock {
   std::atomic<size_t> m_serving_ticket;  ///< Tracks the currently served ticket number.
 };
 
+/**
+ * @brief Scoped owner of a lock.
+ *
+ * @details Acquires the lock on construction and releases it when the guard goes out of scope,
+ * so early returns cannot leak a held lock. Interrupts are left untouched; locks that interrupt
+ * handlers take must use `IrqSpinGuard` instead. With lock statistics enabled, `Lock` must also
+ * provide `try_lock`.
+ */
+template <typename Lock>
+class LockGuard {
+ public:
+  explicit LockGuard(Lock& lock, const void* site = lock_site()) : m_lock(lock) {
+    lockdep_check(&this->m_lock, site);
+    lockstat_lock(this->m_stat, site, this->m_lock.try_lock(), this->m_lock.lock());
+    lockdep_acquire(&this->m_lock, site);
+  }
+
+  ~LockGuard() {
+    lockdep_release(&this->m_lock);
+    lockstat_unlock(this->m_stat);
+    this->m_lock.unlock();
+  }
+
+  LockGuard(const LockGuard&) = delete;
+  LockGuard& operator=(const LockGuard&) = delete;
+
+ private:
+  Lock& m_lock;
+  [[no_unique_address]] LockStatSample m_stat;  ///< Empty unless lock statistics are enabled.
+};
+
 #endif  // LOCK_H
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <klibc/string.h>
+
+#include <kernel/api/calls.h>
+#include <kernel/api/syscall.h>
+#include <kernel/arch/x86_64/cpu/syscall.hpp>
+#include <kernel/memory/slab.hpp>
+
+namespace {
+/// @brief End of the lower half, user pointers must lie below it.
+constexpr uint64_t USER_ADDRESS_END = 1ul << 47;
+
+constexpr uint64_t WRITEV_MAX_VECTORS = 1024;  ///< Entries `sys_writev` accepts at most.
+
+bool is_user_range(uint64_t address, uint64_t size) {
+  return address < USER_ADDRESS_END && size <= USER_ADDRESS_END - address;
+}
+
+int64_t sys_null(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) { return 0; }
+
+int64_t sys_exit(uint64_t value, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+  user_exit(static_cast<int64_t>(value));
+}
+
+/**
+ * @details Only checks that the array and the buffers lie in the lower half, there are no user
+ * address spaces yet whose mappings could be checked. The array is copied before it is checked,
+ * so user mode cannot change an entry between the check and its use. It can reach 16 KiB, the
+ * size of the whole system call stack, so the copy is taken from the heap.
+ */
+int64_t sys_writev(uint64_t iov, uint64_t iovcnt, uint64_t, uint64_t, uint64_t, uint64_t) {
+  if (iovcnt == 0) {
+    return 0;
+  }
+
+  if (iovcnt > WRITEV_MAX_VECTORS || !is_user_range(iov, iovcnt * sizeof(struct iovec))) {
+    return -1;
+  }
+
+  auto* vec = static_cast<struct iovec*>(kmalloc(iovcnt * sizeof(struct iovec)));
+
+  if (!vec) {
+    return -1;
+  }
+
+  memcpy(vec, reinterpret_cast<const void*>(iov), iovcnt * sizeof(struct iovec));
+
+  int64_t result = 0;
+
+  for (uint64_t i = 0; i < iovcnt; i++) {
+    if (!is_user_range(reinterpret_cast<uintptr_t>(vec[i].buffer), vec[i].len)) {
+      result = -1;
+      break;
+    }
+  }
+
+  if (result == 0) {
+    result = kernel_writev(vec, static_cast<int>(iovcnt));
+  }
+
+  kfree(vec);
+  return result;
+}
+}  // namespace
+
+/**
+ * @details Entries are in the order of the `SYSCALL_*` numbers.
+ */
+extern "C" const SyscallFunction syscall_table[SYSCALL_COUNT] = {
+    sys_null,
+    sys_exit,
+    sys_writev,
+};
\ No newline at end of file
@@ -1,25 +1,69 @@
+#include <kernel/arch/x86_64/cpu/fpu.hpp>
 #include <kernel/arch/x86_64/cpu/gdt.hpp>
+#include <kernel/arch/x86_64/cpu/idle.hpp>
 #include <kernel/arch/x86_64/cpu/idt.hpp>
+#include <kernel/arch/x86_64/cpu/lapic.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/arch/x86_64/cpu/smp.hpp>
+#include <kernel/arch/x86_64/cpu/syscall.hpp>
 
 #include <kernel/arch/x86_64/arch.hpp>
 #include <kernel/arch/x86_64/drivers/uart.hpp>
+#include <kernel/irq/softirq.hpp>
+#include <kernel/sched/thread.hpp>
+#include <kernel/sync/rcu.hpp>
+#include <kernel/time/clock.hpp>
 
 #include <string_view>
 
 namespace {
 UartDriver uart_driver(PORT1);
-Gdt gdt;
 Idt idt;
+
+/**
+ * @details Stores the owner at the top of each interrupt stack, so the NMI entry path can find the
+ * per-CPU block without trusting the GS base. System calls and interrupts from user mode share the
+ * processor's kernel stack.
+ */
+void load_descriptors(PerCpu* cpu) {
+  cpu->gdt.initialize();
+
+  for (size_t i = 0; i < INTERRUPT_STACK_COUNT; i++) {
+    uint8_t* top = cpu->interrupt_stacks[i] + INTERRUPT_STACK_SIZE - INTERRUPT_STACK_RESERVED;
+
+    __builtin_memcpy(top, &cpu, sizeof(cpu));
+    cpu->gdt.set_interrupt_stack(static_cast<InterruptStack>(i + 1),
+                                 reinterpret_cast<uintptr_t>(top));
+  }
+
+  cpu->kernel_stack = reinterpret_cast<uintptr_t>(cpu->syscall_stack + KERNEL_STACK_SIZE);
+  cpu->gdt.set_kernel_stack(cpu->kernel_stack);
+
+  percpu_install(cpu);
+  syscall_initialize();
 }
+}  // namespace
 
 /**
  * @note This function enters an infinite loop, either halting the CPU or
- * disabling interrupts and halting repeatedly.
+ * disabling interrupts and halting repeatedly. With interrupts enabled, the loop is the idle thread
+ * of the processor: it runs the software interrupts, lets ready threads run until none is left,
+ * the work queue worker among them, and is in the RCU extended quiescent state while idle.
+ * `idle_enter` checks for work after announcing the wait, so a thread woken by an interrupt or by
+ * another processor cannot be missed before it.
  */
 void arch_halt(bool interrupts) {
   if (interrupts) {
     while (true) {
-      arch_hlt();
+      arch_disable_interrupts();
+      softirq_run();
+      arch_enable_interrupts();
+      thread_yield();
+
+      rcu_idle_enter();
+      arch_disable_interrupts();
+      idle_enter([] { return softirq_pending() || thread_ready(); });
+      rcu_idle_exit();
     }
   } else {
     while (true) {
@@ -38,9 +82,31 @@ void arch_initialize() {
   arch_disable_interrupts();
 
   uart_driver.initialize();
-  gdt.initialize();
+  load_descriptors(cpu_data(0));
   idt.initialize();
+  fpu_initialize();
+  thread_cpu_initialize();
+
+  this_cpu()->online.store(true, std::memory_order_release);
+  arch_enable_interrupts();
+}
+
+/**
+ * @details Every processor has its own GDT and TSS in its per-CPU block, the IDT is shared. The
+ * TSC is synchronized before the local APIC timer can use it, and the local APIC is enabled before
+ * the processor is marked online, so cross calls can wake it.
+ */
+void arch_initialize_ap(PerCpu* cpu) {
+  arch_disable_interrupts();
+
+  load_descriptors(cpu);
+  idt.load();
+  fpu_initialize();
+  clock_sync();
+  thread_cpu_initialize();
+  lapic_initialize();
 
+  cpu->online.store(true, std::memory_order_release);
   arch_enable_interrupts();
 }
 
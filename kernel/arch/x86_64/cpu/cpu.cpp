@@ -47,19 +47,68 @@ void enable_pat() { write_msr(MSR_PAT, DEFAULT_PAT); }
 
 void fxsave(uint8_t const* region) { asm volatile("fxsaveq (%0)" ::"r"(region) : "memory"); }
 
-void xsave(uint8_t const* region) {
-  asm volatile("xsaveq (%0)" ::"r"(region), "a"(RFBM_LOW), "d"(RFBM_HIGH) : "memory");
+void xsave(uint8_t const* region, uint64_t mask) {
+  asm volatile("xsaveq (%0)" ::"r"(region), "a"(static_cast<uint32_t>(mask)),
+               "d"(static_cast<uint32_t>(mask >> 32))
+               : "memory");
 }
 
-void xsaveopt(uint8_t const* region) {
-  asm volatile("xsaveopt64 (%0)" ::"r"(region), "a"(RFBM_LOW), "d"(RFBM_HIGH) : "memory");
+void xsaveopt(uint8_t const* region, uint64_t mask) {
+  asm volatile("xsaveopt64 (%0)" ::"r"(region), "a"(static_cast<uint32_t>(mask)),
+               "d"(static_cast<uint32_t>(mask >> 32))
+               : "memory");
 }
-void xrstor(uint8_t const* region) {
-  asm volatile("xrstorq (%0)" ::"r"(region), "a"(RFBM_LOW), "d"(RFBM_HIGH) : "memory");
+
+void xsavec(uint8_t const* region, uint64_t mask) {
+  asm volatile("xsavec64 (%0)" ::"r"(region), "a"(static_cast<uint32_t>(mask)),
+               "d"(static_cast<uint32_t>(mask >> 32))
+               : "memory");
+}
+
+void xsaves(uint8_t const* region, uint64_t mask) {
+  asm volatile("xsaves64 (%0)" ::"r"(region), "a"(static_cast<uint32_t>(mask)),
+               "d"(static_cast<uint32_t>(mask >> 32))
+               : "memory");
+}
+
+void xrstor(uint8_t const* region, uint64_t mask) {
+  asm volatile("xrstorq (%0)" ::"r"(region), "a"(static_cast<uint32_t>(mask)),
+               "d"(static_cast<uint32_t>(mask >> 32))
+               : "memory");
+}
+
+void xrstors(uint8_t const* region, uint64_t mask) {
+  asm volatile("xrstors64 (%0)" ::"r"(region), "a"(static_cast<uint32_t>(mask)),
+               "d"(static_cast<uint32_t>(mask >> 32))
+               : "memory");
+}
+
+void fxrstor(uint8_t const* region) { asm volatile("fxrstorq (%0)" ::"r"(region) : "memory"); }
+
+uint64_t read_xcr0() {
+  uint32_t edx, eax;
+  asm volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+void write_xcr0(uint64_t value) {
+  const uint32_t eax = static_cast<uint32_t>(value);
+  const uint32_t edx = value >> 32;
+  asm volatile("xsetbv" ::"a"(eax), "d"(edx), "c"(0) : "memory");
+}
+
+void monitor(const volatile void* addr) {
+  asm volatile("monitor" ::"a"(addr), "c"(0), "d"(0) : "memory");
+}
+
+void enable_interrupts_and_mwait(uint32_t hint) {
+  asm volatile("sti; mwait" ::"a"(hint), "c"(0) : "memory");
 }
 
-void fxrstor(uint8_t const* region) {
-  asm volatile("fxrstorq (%0)" ::"r"(region), "a"(RFBM_LOW), "d"(RFBM_HIGH) : "memory");
+uint64_t rdtsc() {
+  uint32_t edx, eax;
+  asm volatile("rdtsc" : "=a"(eax), "=d"(edx));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
 }
 
 uintptr_t kernel_gs_base() { return read_msr(MSR_KERNEL_GS_BASE); }
@@ -15,12 +15,16 @@ void dump_interrupt_frame(Iframe* iframe) {
 }
 }  // namespace
 
+/**
+ * @details Only reached for vectors without a registered handler, see `interrupt_register`.
+ */
 extern "C" void exception_handler(Iframe* iframe) {
   dump_interrupt_frame(iframe);
   log_panic("Unhandled Exception %lu!", iframe->vector);
 }
 
-extern "C" void nmi_handler(NmiFrame* nmi) {
-  dump_interrupt_frame(&nmi->regs);
-  log_panic("Unhandled NMI Exception %lu -> %p!", nmi->regs.vector, nmi->expected_gs);
+extern "C" void nmi_handler(Iframe* iframe, uintptr_t interrupted_gs) {
+  dump_interrupt_frame(iframe);
+  log_panic("Unhandled NMI Exception %lu, GS base was %p!", iframe->vector,
+            reinterpret_cast<void*>(interrupted_gs));
 }
\ No newline at end of file
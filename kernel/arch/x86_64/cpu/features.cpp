@@ -7,6 +7,9 @@ bool read_cpuid(CpuidLeaf *leaf, uint32_t leaf_num, uint32_t subleaf_num) {
                            &leaf->values[2], &leaf->values[3]);
 }
 
+/**
+ * @details The feature bits of `CPUID_XSAVE` are in sub-leaf 1, sub-leaf 0 lists state components.
+ */
 bool test_feature(CpuidBit bit) {
   if ((bit.word > 3) || (bit.bit > 31)) {
     return false;
@@ -14,7 +17,7 @@ bool test_feature(CpuidBit bit) {
 
   CpuidLeaf leaf = {};
 
-  if (!read_cpuid(&leaf, bit.leaf, 0)) {
+  if (!read_cpuid(&leaf, bit.leaf, bit.leaf == CPUID_XSAVE ? 1 : 0)) {
     return false;
   }
 
@@ -0,0 +1,308 @@
+#include <klibc/string.h>
+#include <log.hpp>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/features.hpp>
+#include <kernel/arch/x86_64/cpu/fpu.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/memory/memory.hpp>
+#include <kernel/memory/slab.hpp>
+
+namespace {
+/**
+ * @brief Instruction pair used to save and restore the state, in order of preference.
+ */
+enum FpuMode : uint8_t {
+  FPU_MODE_FXSAVE,    ///< FXSAVE / FXRSTOR, x87 and SSE only.
+  FPU_MODE_XSAVE,     ///< XSAVE / XRSTOR, standard format.
+  FPU_MODE_XSAVEOPT,  ///< XSAVEOPT / XRSTOR, standard format, skips unmodified components.
+  FPU_MODE_XSAVEC,    ///< XSAVEC / XRSTOR, compacted format, skips initial components.
+  FPU_MODE_XSAVES,    ///< XSAVES / XRSTORS, compacted format, skips both.
+};
+
+constexpr const char* mode_names[] = {"FXSAVE", "XSAVE", "XSAVEOPT", "XSAVEC", "XSAVES"};
+
+constexpr size_t LEGACY_AREA_SIZE = 512;  ///< x87 and SSE part of every save area.
+constexpr size_t HEADER_SIZE = 64;        ///< XSAVE header following the legacy area.
+constexpr size_t FCW_OFFSET = 0;          ///< x87 control word in the legacy area.
+constexpr size_t MXCSR_OFFSET = 24;       ///< MXCSR in the legacy area.
+
+constexpr size_t XCOMP_BV_OFFSET = LEGACY_AREA_SIZE + 8;  ///< Format and components of the area.
+constexpr uint64_t XCOMP_BV_COMPACTED = 1ul << 63;       ///< The area uses the compacted format.
+
+/// @brief Components the kernel knows how to enable, AVX-512 only as a whole.
+constexpr uint64_t KNOWN_FEATURES = XCR0_X87 | XCR0_SSE | XCR0_AVX | XCR0_AVX512;
+
+FpuMode fpu_mode = FPU_MODE_FXSAVE;
+uint64_t xfeatures = 0;  ///< Components enabled in XCR0 on every processor.
+size_t state_size = LEGACY_AREA_SIZE;
+
+/**
+ * @details Components with the alignment bit in sub-leaf `n` start on a 64 byte boundary in the
+ * compacted format, all others directly follow the previous one.
+ */
+size_t compacted_size(uint64_t features) {
+  size_t size = LEGACY_AREA_SIZE + HEADER_SIZE;
+
+  for (uint32_t n = 2; n < 64; n++) {
+    CpuidLeaf leaf = {};
+
+    if (!(features & (1ul << n)) || !read_cpuid(&leaf, CPUID_XSAVE, n)) {
+      continue;
+    }
+
+    if (leaf.values[2] & 2) {
+      size = align_up(size, static_cast<size_t>(FPU_STATE_ALIGN));
+    }
+
+    size += leaf.values[0];
+  }
+
+  return size;
+}
+
+/**
+ * @details Keeps only the components whose dependencies are supported as well: AVX needs SSE and
+ * the AVX-512 components only work together with AVX.
+ */
+uint64_t select_features() {
+  CpuidLeaf leaf = {};
+  read_cpuid(&leaf, CPUID_XSAVE, 0);
+
+  uint64_t features = static_cast<uint64_t>(leaf.values[3]) << 32 | leaf.values[0];
+  features &= KNOWN_FEATURES;
+
+  if (!(features & XCR0_SSE)) {
+    features &= ~XCR0_AVX;
+  }
+
+  if (!(features & XCR0_AVX) || (features & XCR0_AVX512) != XCR0_AVX512) {
+    features &= ~XCR0_AVX512;
+  }
+
+  return features | XCR0_X87;
+}
+
+void select_mode() {
+  if (!test_feature(FEATURE_XSAVE)) {
+    fpu_mode = FPU_MODE_FXSAVE;
+    state_size = LEGACY_AREA_SIZE;
+    return;
+  }
+
+  xfeatures = select_features();
+
+  if (test_feature(FEATURE_XSAVES)) {
+    fpu_mode = FPU_MODE_XSAVES;
+  } else if (test_feature(FEATURE_XSAVEC)) {
+    fpu_mode = FPU_MODE_XSAVEC;
+  } else if (test_feature(FEATURE_XSAVEOPT)) {
+    fpu_mode = FPU_MODE_XSAVEOPT;
+  } else {
+    fpu_mode = FPU_MODE_XSAVE;
+  }
+}
+
+/// @brief Returns the size of the standard format area, XCR0 must already be written.
+size_t standard_size() {
+  CpuidLeaf leaf = {};
+  read_cpuid(&leaf, CPUID_XSAVE, 0);
+  return leaf.values[1];
+}
+
+void save(FpuState* state) {
+  switch (fpu_mode) {
+    case FPU_MODE_XSAVES:
+      xsaves(state->area, xfeatures);
+      break;
+    case FPU_MODE_XSAVEC:
+      xsavec(state->area, xfeatures);
+      break;
+    case FPU_MODE_XSAVEOPT:
+      xsaveopt(state->area, xfeatures);
+      break;
+    case FPU_MODE_XSAVE:
+      xsave(state->area, xfeatures);
+      break;
+    case FPU_MODE_FXSAVE:
+      fxsave(state->area);
+      break;
+  }
+}
+
+/**
+ * @brief Saves the registers of the running context if they are loaded.
+ */
+void save_current(PerCpu* cpu) {
+  FpuState* current = cpu->fpu_current;
+
+  if (current && current == cpu->fpu_owner && !cpu->fpu_load_pending) {
+    save(current);
+  }
+}
+
+void restore(FpuState* state) {
+  switch (fpu_mode) {
+    case FPU_MODE_XSAVES:
+      xrstors(state->area, xfeatures);
+      break;
+    case FPU_MODE_XSAVEC:
+    case FPU_MODE_XSAVEOPT:
+    case FPU_MODE_XSAVE:
+      xrstor(state->area, xfeatures);
+      break;
+    case FPU_MODE_FXSAVE:
+      fxrstor(state->area);
+      break;
+  }
+}
+}  // namespace
+
+/**
+ * @details Clears CR0.EM and CR0.TS so the instructions execute without faulting, and sets
+ * CR0.MP and CR0.NE for native x87 error reporting.
+ */
+void fpu_initialize() {
+  const bool first = this_cpu()->index == 0;
+
+  if (first) {
+    select_mode();
+  }
+
+  write_cr0((read_cr0() & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+
+  uint64_t cr4 = read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT;
+
+  if (fpu_mode != FPU_MODE_FXSAVE) {
+    cr4 |= CR4_OSXSAVE;
+  }
+
+  write_cr4(cr4);
+
+  if (fpu_mode != FPU_MODE_FXSAVE) {
+    write_xcr0(xfeatures);
+  }
+
+  if (first) {
+    if (fpu_mode >= FPU_MODE_XSAVEC) {
+      state_size = compacted_size(xfeatures);
+    } else if (fpu_mode != FPU_MODE_FXSAVE) {
+      state_size = standard_size();
+    }
+
+    log_info("FPU state: %s, components %#lx, %lu bytes", mode_names[fpu_mode], xfeatures,
+             state_size);
+  }
+
+  this_cpu_write(fpu_kernel_usable, 1u);
+}
+
+size_t fpu_state_size() { return state_size; }
+
+/**
+ * @details An XSAVE header without any component bits restores every component to its initial
+ * state, only MXCSR is always read from the legacy area.
+ */
+bool fpu_state_init(FpuState* state) {
+  state->area = static_cast<uint8_t*>(kmalloc_aligned(state_size, FPU_STATE_ALIGN));
+  state->last_cpu = FPU_NO_CPU;
+
+  if (!state->area) {
+    return false;
+  }
+
+  memset(state->area, 0, state_size);
+
+  const uint16_t fcw = FPU_DEFAULT_FCW;
+  const uint32_t mxcsr = FPU_DEFAULT_MXCSR;
+
+  memcpy(state->area + FCW_OFFSET, &fcw, sizeof(fcw));
+  memcpy(state->area + MXCSR_OFFSET, &mxcsr, sizeof(mxcsr));
+
+  if (fpu_mode >= FPU_MODE_XSAVEC) {
+    const uint64_t xcomp_bv = XCOMP_BV_COMPACTED | xfeatures;
+    memcpy(state->area + XCOMP_BV_OFFSET, &xcomp_bv, sizeof(xcomp_bv));
+  }
+
+  return true;
+}
+
+/**
+ * @details A context is freed on the processor it ran on, so only that processor can still hold
+ * the state as its owner.
+ */
+void fpu_state_destroy(FpuState* state) {
+  const uint64_t flags = arch_interrupt_save();
+  PerCpu* cpu = this_cpu();
+
+  if (cpu->fpu_owner == state) {
+    cpu->fpu_owner = nullptr;
+  }
+
+  arch_interrupt_restore(flags);
+
+  kfree(state->area);
+  state->area = nullptr;
+}
+
+/**
+ * @details The registers belong to the previous state while it is the owner and no load is
+ * pending. The owner stays set after the save, so switching back before another state was loaded
+ * skips the restore. Switching inside a kernel FPU section would lose its registers.
+ */
+void fpu_switch(FpuState* next) {
+  PerCpu* cpu = this_cpu();
+
+  if (!cpu->fpu_kernel_usable) {
+    log_panic("Context switch inside a kernel FPU section.");
+  }
+
+  save_current(cpu);
+
+  cpu->fpu_current = next;
+  cpu->fpu_load_pending = next && !(next == cpu->fpu_owner && next->last_cpu == cpu->index);
+}
+
+extern "C" void fpu_load() {
+  PerCpu* cpu = this_cpu();
+  FpuState* state = cpu->fpu_current;
+
+  cpu->fpu_load_pending = 0;
+
+  if (!state) {
+    return;
+  }
+
+  restore(state);
+  cpu->fpu_owner = state;
+  state->last_cpu = cpu->index;
+}
+
+bool kernel_fpu_usable() { return this_cpu_read(fpu_kernel_usable) != 0; }
+
+/**
+ * @details Interrupts are disabled while the registers change hands, so an interrupt handler sees
+ * either the context's registers or a section in progress. The owner is cleared, the registers no
+ * longer match any saved state.
+ */
+void kernel_fpu_begin() {
+  const uint64_t flags = arch_interrupt_save();
+  PerCpu* cpu = this_cpu();
+
+  if (!cpu->fpu_kernel_usable) {
+    log_panic("Kernel FPU section started while the FPU is not usable.");
+  }
+
+  cpu->fpu_kernel_usable = 0;
+  save_current(cpu);
+  cpu->fpu_owner = nullptr;
+  cpu->fpu_load_pending = cpu->fpu_current != nullptr;
+
+  arch_interrupt_restore(flags);
+
+  const uint32_t mxcsr = FPU_DEFAULT_MXCSR;
+  asm volatile("ldmxcsr %0" ::"m"(mxcsr));
+}
+
+void kernel_fpu_end() { this_cpu_write(fpu_kernel_usable, 1u); }
\ No newline at end of file
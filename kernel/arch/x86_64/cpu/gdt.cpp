@@ -86,4 +86,10 @@ void Gdt::load() {
 
   load_gdt(&gdtr);
   load_tss();
-}
\ No newline at end of file
+}
+
+void Gdt::set_interrupt_stack(InterruptStack ist, uintptr_t stack_top) {
+  this->m_tss.ist[ist - 1] = stack_top;
+}
+
+void Gdt::set_kernel_stack(uintptr_t stack_top) { this->m_tss.rsp[0] = stack_top; }
\ No newline at end of file
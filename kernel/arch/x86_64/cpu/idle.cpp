@@ -0,0 +1,171 @@
+#include <log.hpp>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/features.hpp>
+#include <kernel/arch/x86_64/cpu/idle.hpp>
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+#include <kernel/arch/x86_64/cpu/lapic.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/time/clock.hpp>
+#include <kernel/time/timer.hpp>
+
+namespace {
+/**
+ * @brief C-state `mwait` can enter.
+ */
+struct IdleState {
+  uint32_t hint;          ///< Value of `%eax` for `mwait`.
+  uint64_t residency_ns;  ///< Shortest idle period the state pays off for.
+};
+
+/**
+ * @details Target residencies of the MWAIT C-states C1 to C7. Without ACPI tables that report the
+ * real values, these are conservative figures of current processors.
+ */
+constexpr uint64_t residencies_ns[IDLE_MAX_STATES - 1] = {
+    0, 20000, 100000, 300000, 600000, 800000, 800000,
+};
+
+constexpr uint32_t MWAIT_SUBSTATE_BITS = 4;    ///< Width of a sub-state count in `%edx`.
+constexpr uint32_t MWAIT_SUBSTATE_MASK = 0xf;  ///< Mask of a sub-state count in `%edx`.
+constexpr uint32_t MWAIT_CSTATE_SHIFT = 4;     ///< Position of the C-state in the hint.
+constexpr uint32_t MWAIT_LINE_MASK = 0xffff;   ///< Mask of the monitor line size in `%ebx`.
+constexpr uint32_t MWAIT_ECX_EMX = 1u << 0;    ///< `%ecx`: the sub-state counts are valid.
+
+bool use_mwait = false;
+IdleState states[IDLE_MAX_STATES];
+uint32_t state_count = 0;
+
+/**
+ * @details The interrupt only ends the halt, the idle loop then looks for the work.
+ */
+void wake_handler(Iframe*, void*) { lapic_eoi(); }
+
+/**
+ * @details CPUID leaf 5 reports the number of sub-states of every MWAIT C-state in `%edx`, four
+ * bits each, starting with C0, if the EMX bit in `%ecx` says so. The hint of C-state `n` is
+ * `(n - 1) << 4`, sub-state 0.
+ *
+ * Without ARAT the local APIC timer stops in C3 and deeper, and a TSC deadline that expires there
+ * would only be noticed at the next unrelated interrupt, so the states are capped at C1. Without
+ * the counts only C1 is used.
+ */
+void select_states() {
+  CpuidLeaf leaf = {};
+
+  if (!test_feature(FEATURE_MON) || !read_cpuid(&leaf, CPUID_MON, 0)) {
+    return;
+  }
+
+  const uint32_t substates = (leaf.values[2] & MWAIT_ECX_EMX) ? leaf.values[3] : 0;
+  const uint32_t limit = test_feature(FEATURE_ARAT) ? IDLE_MAX_STATES : 2;
+
+  for (uint32_t n = 1; n < limit; n++) {
+    if ((substates >> (n * MWAIT_SUBSTATE_BITS)) & MWAIT_SUBSTATE_MASK) {
+      states[state_count++] = {(n - 1) << MWAIT_CSTATE_SHIFT, residencies_ns[n - 1]};
+    }
+  }
+
+  if (state_count == 0) {
+    states[state_count++] = {0, 0};
+  }
+
+  use_mwait = true;
+
+  if ((leaf.values[1] & MWAIT_LINE_MASK) > CACHE_LINE_SIZE) {
+    log_warn("MWAIT monitors %u bytes, writes next to the idle flags end the wait.",
+             leaf.values[1] & MWAIT_LINE_MASK);
+  }
+}
+
+/**
+ * @brief Returns the deepest state whose residency the expected idle time reaches.
+ */
+const IdleState& select_state(PerCpu* cpu) {
+  uint64_t expected_ns = cpu->idle_predicted_ns;
+  const uint64_t deadline = timer_next_deadline();
+  const uint64_t now = now_cycles();
+
+  if (deadline) {
+    const uint64_t timer_ns = deadline > now ? cycles_to_ns(deadline - now) : 0;
+    expected_ns = timer_ns < expected_ns ? timer_ns : expected_ns;
+  }
+
+  uint32_t index = state_count - 1;
+
+  while (index > 0 && states[index].residency_ns > expected_ns) {
+    index--;
+  }
+
+  return states[index];
+}
+}  // namespace
+
+void idle_initialize() {
+  select_states();
+  interrupt_register(INTERRUPT_IPI_RESCHEDULE, wake_handler);
+
+  if (use_mwait) {
+    log_info("Idle: MWAIT, %u C-states, deepest hint %#x.", state_count,
+             states[state_count - 1].hint);
+  } else {
+    log_info("Idle: HLT, wakeups need an IPI.");
+  }
+}
+
+/**
+ * @details The flags are written with a full barrier before `work_pending` reads the queues, and
+ * `idle_wake` publishes the work before it reads the flags, so one of the two always sees the
+ * other. Setting `IDLE_WAKE` between the announcement and `monitor` is caught by reading the flags
+ * once more after it. The flags stay set while interrupt handlers run after the wait, wakeups then
+ * need no IPI and the caller looks for work anyway.
+ */
+void idle_enter(bool (*work_pending)()) {
+  PerCpu* cpu = this_cpu();
+
+  cpu->idle_flags.store(use_mwait ? IDLE_POLLING : IDLE_HALTED, std::memory_order_seq_cst);
+
+  if (work_pending()) {
+    cpu->idle_flags.store(0, std::memory_order_relaxed);
+    arch_enable_interrupts();
+    return;
+  }
+
+  const uint64_t start = now_ns();
+
+  if (use_mwait) {
+    const IdleState& state = select_state(cpu);
+
+    monitor(&cpu->idle_flags);
+
+    if (cpu->idle_flags.load(std::memory_order_relaxed) & IDLE_WAKE) {
+      arch_enable_interrupts();
+    } else {
+      enable_interrupts_and_mwait(state.hint);
+    }
+  } else {
+    arch_enable_interrupts_and_hlt();
+  }
+
+  cpu->idle_flags.store(0, std::memory_order_relaxed);
+
+  const uint64_t idle_ns = now_ns() - start;
+  cpu->idle_predicted_ns = cpu->idle_predicted_ns -
+                           (cpu->idle_predicted_ns >> IDLE_PREDICTION_SHIFT) +
+                           (idle_ns >> IDLE_PREDICTION_SHIFT);
+}
+
+void idle_wake(uint32_t cpu) {
+  PerCpu* target = cpu_data(cpu);
+
+  if (target == this_cpu()) {
+    return;
+  }
+
+  const uint32_t flags = target->idle_flags.fetch_or(IDLE_WAKE, std::memory_order_seq_cst);
+
+  if (flags & IDLE_HALTED) {
+    lapic_send_ipi(cpu, INTERRUPT_IPI_RESCHEDULE);
+  }
+}
\ No newline at end of file
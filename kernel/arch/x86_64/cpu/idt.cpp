@@ -2,9 +2,9 @@
 #include <log.hpp>
 
 #include <kernel/arch/x86_64/cpu/exceptions.hpp>
+#include <kernel/arch/x86_64/cpu/gdt.hpp>
 #include <kernel/arch/x86_64/cpu/idt.hpp>
-
-#define KERNEL_CODE_SELECTOR (8)
+#include <kernel/arch/x86_64/regs.h>
 
 #define TYPE_ATTRIBUTE_PRESENT (1 << 7)
 #define TYPE_ATTRIBUTE_DPL(x) (x << 5)
@@ -19,6 +19,21 @@ constexpr uint8_t get_idt_attribute(uint8_t type, uint8_t dpl) {
 
   return ret;
 }
+
+constexpr InterruptStack get_interrupt_stack(int vector) {
+  switch (vector) {
+    case EXCEPTION_NON_MASKABLE_INTERRUPT:
+      return IST_NMI;
+    case EXCEPTION_DOUBLE_FAULT:
+      return IST_DOUBLE_FAULT;
+    case EXCEPTION_MACHINE_CHECK:
+      return IST_MACHINE_CHECK;
+    case EXCEPTION_DEBUG:
+      return IST_DEBUG;
+    default:
+      return IST_NONE;
+  }
+}
 }  // namespace
 
 void IdtSegment::set(uintptr_t base, uint8_t ist, uint8_t type, uint8_t dpl, uint16_t selector) {
@@ -33,7 +48,8 @@ void IdtSegment::set(uintptr_t base, uint8_t ist, uint8_t type, uint8_t dpl, uin
 
 /**
  * @details This function sets up the IDT entries based on the ISR table, configures their
- * attributes, and loads the IDT using the assembly-defined `load_idt` function.
+ * attributes, and loads the IDT using the assembly-defined `load_idt` function. NMI, double fault,
+ * machine check and debug exceptions switch to the per-CPU stacks in the executing processor's TSS.
  */
 void Idt::initialize() {
   uint8_t type = IDT_INTERRUPT_GATE;
@@ -41,7 +57,7 @@ void Idt::initialize() {
   memset(&this->m_table, 0, sizeof(IdtTable));
 
   for (int i = 0; i < MAX_IDT_ENTRIES; i++) {
-    this->m_table.entries[i].set(isr_table[i], 0, type,
+    this->m_table.entries[i].set(isr_table[i], get_interrupt_stack(i), type,
                                  (i == EXCEPTION_BREAKPOINT) ? IDT_DPL3 : IDT_DPL0,
                                  KERNEL_CODE_SELECTOR);
   }
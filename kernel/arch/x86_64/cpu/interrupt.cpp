@@ -0,0 +1,113 @@
+#include <log.hpp>
+
+#include <atomic>
+
+#include <kernel/arch/x86_64/cpu/idt.hpp>
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/irq/softirq.hpp>
+#include <kernel/sync/irq.hpp>
+#include <kernel/sync/rcu.hpp>
+#include <lock.hpp>
+
+/**
+ * @details Read by the entry code in `idt.S`. A handler is published with a release store after
+ * its data, so the entry code never sees a handler with stale data.
+ */
+extern "C" {
+std::atomic<InterruptHandler> interrupt_handlers[MAX_IDT_ENTRIES];
+void* interrupt_data[MAX_IDT_ENTRIES];
+}
+
+static_assert(sizeof(std::atomic<InterruptHandler>) == sizeof(uintptr_t));
+
+namespace {
+TicketLock registry_lock;  ///< Serializes changes of the handler table.
+
+bool install(uint8_t vector, InterruptHandler handler, void* data) {
+  if (interrupt_handlers[vector].load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  interrupt_data[vector] = data;
+  interrupt_handlers[vector].store(handler, std::memory_order_release);
+  return true;
+}
+}  // namespace
+
+/**
+ * @details Called by the entry code after a handler raised software interrupts. They only run for
+ * external interrupts that arrived with interrupts enabled: exceptions may have interrupted a
+ * section with interrupts disabled, or run on an interrupt stack that must not be reentered. An
+ * interrupt that woke an idle processor arrives in the RCU extended quiescent state, which the
+ * software interrupts leave while they run, since their handlers may read RCU protected data.
+ */
+extern "C" void interrupt_exit(Iframe* iframe) {
+  if (iframe->vector >= PLATFORM_INTERRUPT_BASE && (iframe->flags & ARCH_FLAGS_IF)) {
+    const bool idle = rcu_irq_enter();
+    softirq_run();
+    rcu_irq_exit(idle);
+  }
+}
+
+/**
+ * @details The NMI vector takes a separate entry path that does not use the table.
+ */
+bool interrupt_register(uint8_t vector, InterruptHandler handler, void* data) {
+  if (vector == EXCEPTION_NON_MASKABLE_INTERRUPT) {
+    return false;
+  }
+
+  IrqSpinGuard guard(registry_lock);
+  return install(vector, handler, data);
+}
+
+uint8_t interrupt_allocate(InterruptHandler handler, void* data) {
+  IrqSpinGuard guard(registry_lock);
+
+  for (uint32_t vector = INTERRUPT_DYNAMIC_BASE; vector < INTERRUPT_DYNAMIC_END; vector++) {
+    if (install(static_cast<uint8_t>(vector), handler, data)) {
+      return static_cast<uint8_t>(vector);
+    }
+  }
+
+  log_warn("No free interrupt vector left.");
+  return 0;
+}
+
+void interrupt_unregister(uint8_t vector) {
+  IrqSpinGuard guard(registry_lock);
+
+  interrupt_handlers[vector].store(nullptr, std::memory_order_release);
+  interrupt_data[vector] = nullptr;
+}
+
+/**
+ * @details The counters of other processors are read without synchronization, so a concurrent
+ * interrupt may be counted without its cycles.
+ */
+InterruptStats interrupt_stats(uint8_t vector) {
+  InterruptStats total = {};
+
+  for (uint32_t i = 0; i < cpu_count(); i++) {
+    const InterruptStats& stats = cpu_data(i)->interrupt_stats[vector];
+
+    total.count += __atomic_load_n(&stats.count, __ATOMIC_RELAXED);
+    total.cycles += __atomic_load_n(&stats.cycles, __ATOMIC_RELAXED);
+  }
+
+  return total;
+}
+
+void interrupt_dump() {
+  log_info("Interrupts by vector:");
+
+  for (uint32_t vector = 0; vector < MAX_IDT_ENTRIES; vector++) {
+    const InterruptStats stats = interrupt_stats(static_cast<uint8_t>(vector));
+
+    if (stats.count) {
+      log_info("  %3u count: %lu cycles: %lu avg: %lu", vector, stats.count, stats.cycles,
+               stats.cycles / stats.count);
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include <log.hpp>
+
+#include <algorithm>
+
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/exceptions.hpp>
+#include <kernel/arch/x86_64/cpu/features.hpp>
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+#include <kernel/arch/x86_64/cpu/lapic.hpp>
+#include <kernel/arch/x86_64/cpu/paging.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+
+#define X2APIC_MSR_BASE 0x800u  ///< MSR of the x2APIC register at offset 0.
+
+static_assert(X2APIC_MSR_BASE + (LAPIC_REG_EOI >> 4) == MSR_X2APIC_EOI);
+static_assert(X2APIC_MSR_BASE + (LAPIC_REG_ICR_LOW >> 4) == MSR_X2APIC_ICR);
+static_assert(X2APIC_MSR_BASE + (LAPIC_REG_SELF_IPI >> 4) == MSR_X2APIC_SELF_IPI);
+
+namespace {
+bool x2apic = false;
+bool tsc_deadline = false;
+volatile uint32_t* mmio = nullptr;  ///< xAPIC register page, unused in x2APIC mode.
+uint64_t ticks_per_cycle = 0;       ///< Timer ticks per TSC cycle in 32.32 fixed point.
+
+uint32_t read_reg(uint32_t reg) {
+  if (x2apic) {
+    return static_cast<uint32_t>(read_msr(X2APIC_MSR_BASE + (reg >> 4)));
+  }
+
+  return mmio[reg / sizeof(uint32_t)];
+}
+
+void write_reg(uint32_t reg, uint32_t value) {
+  if (x2apic) {
+    write_msr(X2APIC_MSR_BASE + (reg >> 4), value);
+  } else {
+    mmio[reg / sizeof(uint32_t)] = value;
+  }
+}
+
+/**
+ * @details Writes to the x2APIC MSRs are not serializing, so stores made before an IPI, e.g. to
+ * the target's cross call mailbox, could otherwise become visible only after the IPI arrived.
+ */
+void ipi_fence() { asm volatile("mfence; lfence" ::: "memory"); }
+
+/**
+ * @details In xAPIC mode the command takes two register writes, and the next command must not be
+ * written before the previous one was accepted. Interrupts are disabled so a handler on the same
+ * processor cannot send an IPI in between.
+ */
+void send(uint32_t destination, uint32_t command) {
+  if (x2apic) {
+    ipi_fence();
+    write_msr(MSR_X2APIC_ICR, (static_cast<uint64_t>(destination) << 32) | command);
+    return;
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+
+  while (read_reg(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING) {
+    arch_pause();
+  }
+
+  write_reg(LAPIC_REG_ICR_HIGH, destination << 24);
+  write_reg(LAPIC_REG_ICR_LOW, command);
+
+  arch_interrupt_restore(flags);
+}
+
+/**
+ * @details Counts the timer ticks that pass during `LAPIC_TIMER_CALIBRATION_CYCLES` TSC cycles.
+ * The timer is masked, so running out of ticks does not raise an interrupt.
+ */
+void calibrate_timer() {
+  write_reg(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+  write_reg(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_ONE_SHOT | INTERRUPT_APIC_TIMER);
+  write_reg(LAPIC_REG_TIMER_INIT, UINT32_MAX);
+
+  const uint64_t start = rdtsc();
+  while (rdtsc() - start < LAPIC_TIMER_CALIBRATION_CYCLES) {
+    arch_pause();
+  }
+
+  const uint64_t ticks = UINT32_MAX - read_reg(LAPIC_REG_TIMER_CURRENT);
+  write_reg(LAPIC_REG_TIMER_INIT, 0);
+
+  ticks_per_cycle = (ticks << 32) / LAPIC_TIMER_CALIBRATION_CYCLES;
+  log_info("Local APIC timer runs at %lu ticks per %lu TSC cycles.", ticks,
+           LAPIC_TIMER_CALIBRATION_CYCLES);
+}
+
+/**
+ * @details The timer starts out disarmed: a zero deadline and a zero initial count both stop it.
+ */
+void timer_initialize() {
+  if (tsc_deadline) {
+    write_reg(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_TSC_DEADLINE | INTERRUPT_APIC_TIMER);
+    write_msr(MSR_TSC_DEADLINE, 0);
+  } else {
+    write_reg(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    write_reg(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_ONE_SHOT | INTERRUPT_APIC_TIMER);
+    write_reg(LAPIC_REG_TIMER_INIT, 0);
+  }
+}
+
+/**
+ * @details Spurious interrupts are not in service and must not be acknowledged.
+ */
+void spurious_handler(Iframe*, void*) {}
+
+void error_handler(Iframe*, void*) {
+  lapic_handle_error();
+  lapic_eoi();
+}
+
+/// @brief Keeps only the bits of processors that exist.
+uint64_t existing_cpus(uint64_t cpus) {
+  return cpu_count() < 64 ? cpus & ((1ul << cpu_count()) - 1) : cpus;
+}
+}  // namespace
+
+/**
+ * @details The error vector is programmed and the error status cleared before the APIC is
+ * software-enabled. The timer is set up disarmed, LINT entries keep the state the firmware left
+ * them in.
+ */
+void lapic_initialize() {
+  static bool selected = false;
+
+  if (!selected) {
+    x2apic = test_feature(FEATURE_X2APIC);
+    tsc_deadline = test_feature(FEATURE_TSC_DEADLINE);
+
+    if (!x2apic) {
+      const uintptr_t base = read_msr(MSR_APIC_BASE) & APIC_BASE_ADDRESS_MASK;
+      mmio = static_cast<volatile uint32_t*>(map_mmio(base, LAPIC_MMIO_SIZE));
+    }
+
+    interrupt_register(INTERRUPT_APIC_SPURIOUS, spurious_handler);
+    interrupt_register(INTERRUPT_APIC_ERROR, error_handler);
+
+    selected = true;
+    log_info("Local APIC in %s mode, timer in %s mode.", x2apic ? "x2APIC" : "xAPIC",
+             tsc_deadline ? "TSC-deadline" : "one-shot");
+  }
+
+  write_msr(MSR_APIC_BASE,
+            read_msr(MSR_APIC_BASE) | APIC_BASE_ENABLE | (x2apic ? APIC_BASE_X2APIC : 0));
+
+  write_reg(LAPIC_REG_TPR, 0);
+  write_reg(LAPIC_REG_LVT_ERROR, INTERRUPT_APIC_ERROR);
+  write_reg(LAPIC_REG_ESR, 0);
+  write_reg(LAPIC_REG_ESR, 0);
+  write_reg(LAPIC_REG_SIVR, LAPIC_SIVR_ENABLE | INTERRUPT_APIC_SPURIOUS);
+
+  if (!tsc_deadline && !ticks_per_cycle) {
+    calibrate_timer();
+  }
+
+  timer_initialize();
+
+  PerCpu* cpu = this_cpu();
+  cpu->lapic_id = lapic_id();
+  cpu->lapic_ldr = x2apic ? read_reg(LAPIC_REG_LDR) : 0;
+}
+
+bool lapic_x2apic() { return x2apic; }
+
+uint32_t lapic_id() {
+  const uint32_t id = read_reg(LAPIC_REG_ID);
+  return x2apic ? id : id >> 24;
+}
+
+void lapic_eoi() { write_reg(LAPIC_REG_EOI, 0); }
+
+/**
+ * @details The error status register only latches new errors after a write.
+ */
+void lapic_handle_error() {
+  write_reg(LAPIC_REG_ESR, 0);
+  log_error("Local APIC %u error, status 0x%x.", lapic_id(), read_reg(LAPIC_REG_ESR));
+}
+
+/**
+ * @details The write of the deadline MSR is not serializing, so it is fenced like an IPI to keep
+ * it from passing earlier stores. The one-shot fallback converts the remaining TSC cycles into
+ * timer ticks, saturating at the largest initial count.
+ */
+void lapic_timer_arm(uint64_t deadline) {
+  if (tsc_deadline) {
+    ipi_fence();
+    write_msr(MSR_TSC_DEADLINE, deadline);
+    return;
+  }
+
+  const uint64_t now = rdtsc();
+  const uint64_t cycles = deadline > now ? deadline - now : 0;
+  const uint64_t ticks =
+      static_cast<uint64_t>((static_cast<unsigned __int128>(cycles) * ticks_per_cycle) >> 32);
+
+  write_reg(LAPIC_REG_TIMER_INIT,
+            static_cast<uint32_t>(std::clamp<uint64_t>(ticks, 1, UINT32_MAX)));
+}
+
+void lapic_timer_disarm() {
+  if (tsc_deadline) {
+    write_msr(MSR_TSC_DEADLINE, 0);
+  } else {
+    write_reg(LAPIC_REG_TIMER_INIT, 0);
+  }
+}
+
+void lapic_send_ipi(uint32_t cpu, uint8_t vector) {
+  send(cpu_data(cpu)->lapic_id, LAPIC_ICR_ASSERT | vector);
+}
+
+void lapic_send_ipi_self(uint8_t vector) {
+  if (x2apic) {
+    ipi_fence();
+    write_msr(MSR_X2APIC_SELF_IPI, vector);
+  } else {
+    send(0, LAPIC_ICR_SELF | LAPIC_ICR_ASSERT | vector);
+  }
+}
+
+void lapic_send_ipi_others(uint8_t vector) {
+  send(0, LAPIC_ICR_OTHERS | LAPIC_ICR_ASSERT | vector);
+}
+
+/**
+ * @details An x2APIC logical ID holds the cluster in bits 16-31 and one of 16 processors of the
+ * cluster in bits 0-15, so all targets of a cluster are combined into one logical destination.
+ * xAPIC flat logical mode only covers 8 processors, so there every target gets its own IPI.
+ */
+void lapic_send_ipi_mask(uint64_t cpus, uint8_t vector) {
+  cpus = existing_cpus(cpus);
+
+  if (!x2apic) {
+    for (; cpus; cpus &= cpus - 1) {
+      lapic_send_ipi(__builtin_ctzl(cpus), vector);
+    }
+
+    return;
+  }
+
+  while (cpus) {
+    const uint32_t cluster = cpu_data(__builtin_ctzl(cpus))->lapic_ldr & 0xffff0000u;
+    uint32_t destination = cluster;
+
+    for (uint64_t rest = cpus; rest; rest &= rest - 1) {
+      const uint32_t cpu = __builtin_ctzl(rest);
+      const uint32_t ldr = cpu_data(cpu)->lapic_ldr;
+
+      if ((ldr & 0xffff0000u) == cluster) {
+        destination |= ldr & 0xffffu;
+        cpus &= ~(1ul << cpu);
+      }
+    }
+
+    send(destination, LAPIC_ICR_LOGICAL | LAPIC_ICR_ASSERT | vector);
+  }
+}
\ No newline at end of file
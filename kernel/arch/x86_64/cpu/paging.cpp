@@ -0,0 +1,145 @@
+#include <log.hpp>
+
+#include <kernel/kernel.h>
+
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/paging.hpp>
+#include <kernel/memory/memory.hpp>
+#include <kernel/memory/physical.hpp>
+#include <lock.hpp>
+
+namespace {
+TicketLock page_table_lock;  ///< Serializes changes of the shared kernel page tables.
+
+/**
+ * @details The power-on PAT maps index 3, selected by both caching bits, to uncacheable.
+ */
+constexpr uint64_t MMIO_FLAGS =
+    PTE_PRESENT | PTE_WRITABLE | PTE_WRITE_THROUGH | PTE_CACHE_DISABLE | PTE_NO_EXECUTE;
+
+constexpr uint64_t FIRMWARE_FLAGS = PTE_PRESENT | PTE_NO_EXECUTE;
+
+uint64_t* table_at(uint64_t entry) {
+  return reinterpret_cast<uint64_t*>(to_higher_half(entry & PTE_ADDRESS_MASK));
+}
+
+/**
+ * @brief Returns the last level entry for `virt`, allocating missing tables on the way.
+ * @param user Set `PTE_USER` on the entries leading to `virt`.
+ * @return `nullptr` if a huge page already maps `virt`.
+ */
+uint64_t* walk(uintptr_t virt, bool user = false) {
+  const uint64_t table_flags = PTE_PRESENT | PTE_WRITABLE | (user ? PTE_USER : 0);
+  const size_t levels = PAGING_MODE_MAX ? 5 : 4;
+  uint64_t* table = table_at(read_cr3());
+
+  for (size_t level = levels; level > 1; level--) {
+    const size_t shift = 12 + 9 * (level - 1);
+    uint64_t& entry = table[(virt >> shift) % PAGE_TABLE_ENTRIES];
+
+    if (!(entry & PTE_PRESENT)) {
+      entry = phys_allocator.allocate(PAGE_SIZE_4KiB) | table_flags;
+    } else if (entry & PTE_HUGE) {
+      return nullptr;
+    } else {
+      entry |= table_flags & PTE_USER;
+    }
+
+    table = table_at(entry);
+  }
+
+  return &table[(virt >> 12) % PAGE_TABLE_ENTRIES];
+}
+
+/**
+ * @brief Maps the pages covering `[phys, phys + size)` into the direct map with `flags`.
+ * @details Pages that are already mapped are left alone.
+ * @return `false` if a huge page maps part of the range, which keeps its own attributes.
+ */
+bool map_direct(uintptr_t phys, size_t size, uint64_t flags) {
+  const uintptr_t first = align_down(phys, static_cast<uintptr_t>(PAGE_SIZE_4KiB));
+  const uintptr_t last = align_up(phys + size, static_cast<uintptr_t>(PAGE_SIZE_4KiB));
+  bool mapped = true;
+
+  LockGuard guard(page_table_lock);
+
+  for (uintptr_t page = first; page < last; page += PAGE_SIZE_4KiB) {
+    const uintptr_t virt = to_higher_half(page);
+    uint64_t* entry = walk(virt);
+
+    if (!entry) {
+      mapped = false;
+    } else if (!(*entry & PTE_PRESENT)) {
+      *entry = page | flags;
+      invalidate_page(virt);
+    }
+  }
+
+  return mapped;
+}
+}  // namespace
+
+/**
+ * @details Pages that are already mapped are left alone, so overlapping ranges can be mapped more
+ * than once. A huge page covering the range means the region was mapped as RAM by the bootloader;
+ * it stays cached and a warning is logged.
+ */
+void* map_mmio(uintptr_t phys, size_t size) {
+  if (!map_direct(phys, size, MMIO_FLAGS)) {
+    log_warn("MMIO range %p is part of a huge page and stays cached.",
+             reinterpret_cast<void*>(phys));
+  }
+
+  return reinterpret_cast<void*>(to_higher_half(phys));
+}
+
+/**
+ * @details Tables in memory the bootloader mapped as RAM are already accessible, huge pages
+ * included, only those in reserved memory get new pages.
+ */
+const void* map_firmware(uintptr_t phys, size_t size) {
+  map_direct(phys, size, FIRMWARE_FLAGS);
+  return reinterpret_cast<const void*>(to_higher_half(phys));
+}
+
+/**
+ * @details All processors share the kernel half of the tables, so the page is visible everywhere
+ * without further synchronization.
+ */
+bool map_kernel_page(uintptr_t virt, uintptr_t phys, uint64_t flags) {
+  if (virt % PAGE_SIZE_4KiB || virt < (0ul - (1ul << 47))) {
+    return false;
+  }
+
+  LockGuard guard(page_table_lock);
+  uint64_t* entry = walk(virt);
+
+  if (!entry || (*entry & PTE_PRESENT)) {
+    return false;
+  }
+
+  *entry = (phys & PTE_ADDRESS_MASK) | PTE_PRESENT | flags;
+  invalidate_page(virt);
+  return true;
+}
+
+/**
+ * @details The tables of the lower half are shared by all processors like the rest, there are no
+ * per-process address spaces yet.
+ */
+bool map_user_page(uintptr_t virt, uintptr_t phys, uint64_t flags) {
+  if (virt % PAGE_SIZE_4KiB || virt >= (1ul << 47)) {
+    return false;
+  }
+
+  LockGuard guard(page_table_lock);
+  uint64_t* entry = walk(virt, true);
+
+  if (!entry || (*entry & PTE_PRESENT)) {
+    return false;
+  }
+
+  *entry = (phys & PTE_ADDRESS_MASK) | PTE_PRESENT | PTE_USER | flags;
+  invalidate_page(virt);
+  return true;
+}
\ No newline at end of file
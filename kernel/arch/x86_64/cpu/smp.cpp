@@ -0,0 +1,198 @@
+#include <log.hpp>
+
+#include <span>
+
+#include <kernel/kernel.h>
+
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/exceptions.hpp>
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+#include <kernel/arch/x86_64/cpu/lapic.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/arch/x86_64/cpu/smp.hpp>
+#include <lock.hpp>
+
+namespace {
+PerCpu cpus[MAX_CPUS];  ///< Index 0 belongs to the boot processor.
+uint32_t count = 1;
+
+TicketLock call_lock;  ///< Serializes cross calls, each processor has a single mailbox.
+
+void ap_entry(limine_mp_info* info) {
+  auto* cpu = reinterpret_cast<PerCpu*>(info->extra_argument);
+
+  arch_initialize_ap(cpu);
+  smp_idle();
+}
+
+/**
+ * @details Only posts the call, the caller sends the IPI, possibly one for several processors.
+ */
+void post_call(PerCpu* cpu, SmpFunction function, void* arg) {
+  cpu->call_arg = arg;
+  cpu->call_function.store(function, std::memory_order_release);
+}
+
+void call_handler(Iframe*, void*) {
+  lapic_eoi();
+  smp_handle_call();
+}
+
+void wait_call(PerCpu* cpu) {
+  while (cpu->call_function.load(std::memory_order_acquire)) {
+    arch_pause();
+  }
+}
+
+/**
+ * @details Callers have interrupts disabled, so the IPI of a call posted to them while they wait
+ * would never arrive and the holder of the lock would wait for them forever. They run such a call
+ * between attempts instead.
+ */
+void lock_calls() {
+  while (!call_lock.try_lock()) {
+    smp_handle_call();
+    arch_pause();
+  }
+}
+}  // namespace
+
+PerCpu* cpu_data(uint32_t index) { return &cpus[index]; }
+
+uint32_t cpu_count() { return count; }
+
+void percpu_install(PerCpu* cpu) {
+  cpu->self = cpu;
+
+  set_gs_base(reinterpret_cast<uintptr_t>(cpu));
+  set_kernel_gs_base(0);
+}
+
+/**
+ * @details Limine parks every application processor until its `goto_address` is written. Each one
+ * is handed its per-CPU block through `extra_argument` before it is released, the boot processor
+ * then waits for all of them to report in.
+ */
+void arch_smp_initialize() {
+  limine_mp_response* response = mp_request.response;
+
+  interrupt_register(INTERRUPT_IPI_GENERIC, call_handler);
+  lapic_initialize();
+
+  if (!response) {
+    log_warn("Bootloader did not provide application processors.");
+    return;
+  }
+
+  std::span<limine_mp_info*> infos(response->cpus, response->cpu_count);
+
+  for (auto info : infos) {
+    if (info->lapic_id == response->bsp_lapic_id) {
+      cpus[0].lapic_id = info->lapic_id;
+      cpus[0].processor_id = info->processor_id;
+      continue;
+    }
+
+    if (count == MAX_CPUS) {
+      log_warn("Ignoring processors beyond the first %d.", MAX_CPUS);
+      break;
+    }
+
+    PerCpu* cpu = &cpus[count];
+    cpu->self = cpu;
+    cpu->index = count++;
+    cpu->lapic_id = info->lapic_id;
+    cpu->processor_id = info->processor_id;
+
+    info->extra_argument = reinterpret_cast<uint64_t>(cpu);
+    __atomic_store_n(&info->goto_address, &ap_entry, __ATOMIC_RELEASE);
+  }
+
+  uint32_t online = 1;
+
+  for (uint32_t i = 1; i < count; i++) {
+    for (size_t spin = 0; spin < SMP_STARTUP_SPIN_LIMIT; spin++) {
+      if (cpus[i].online.load(std::memory_order_acquire)) {
+        break;
+      }
+
+      arch_pause();
+    }
+
+    if (cpus[i].online.load(std::memory_order_acquire)) {
+      online++;
+    } else {
+      log_error("Processor %u (LAPIC ID %u) did not come online.", i, cpus[i].lapic_id);
+    }
+  }
+
+  log_info("Started %u of %u processors.", online, count);
+}
+
+void smp_idle() { arch_halt(true); }
+
+void smp_handle_call() {
+  PerCpu* cpu = this_cpu();
+  SmpFunction function = cpu->call_function.load(std::memory_order_acquire);
+
+  if (function) {
+    function(cpu->call_arg);
+    cpu->call_function.store(nullptr, std::memory_order_release);
+  }
+}
+
+/**
+ * @note Cross calls must not be issued from within a cross call, the caller holds `call_lock` until
+ * the callee returned.
+ */
+bool smp_call(uint32_t cpu, SmpFunction function, void* arg) {
+  if (cpu >= count || !cpus[cpu].online.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+
+  if (cpu == arch_cpu_index()) {
+    function(arg);
+  } else {
+    lock_calls();
+    post_call(&cpus[cpu], function, arg);
+    lapic_send_ipi(cpu, INTERRUPT_IPI_GENERIC);
+    wait_call(&cpus[cpu]);
+    call_lock.unlock();
+  }
+
+  arch_interrupt_restore(flags);
+  return true;
+}
+
+/**
+ * @details Posts the call to every other processor first and wakes all of them with one IPI per
+ * x2APIC cluster, so they run it in parallel with the caller.
+ */
+void smp_call_all(SmpFunction function, void* arg) {
+  const uint64_t flags = arch_interrupt_save();
+  const uint32_t self = arch_cpu_index();
+  uint64_t targets = 0;
+
+  lock_calls();
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (i != self && cpus[i].online.load(std::memory_order_acquire)) {
+      post_call(&cpus[i], function, arg);
+      targets |= 1ul << i;
+    }
+  }
+
+  lapic_send_ipi_mask(targets, INTERRUPT_IPI_GENERIC);
+  function(arg);
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (i != self) {
+      wait_call(&cpus[i]);
+    }
+  }
+
+  call_lock.unlock();
+  arch_interrupt_restore(flags);
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include <log.hpp>
+
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/features.hpp>
+#include <kernel/arch/x86_64/cpu/syscall.hpp>
+#include <kernel/arch/x86_64/regs.h>
+
+#ifdef ENABLE_BENCHMARKS
+#include <klibc/string.h>
+
+#include <kernel/arch/x86_64/cpu/paging.hpp>
+#include <kernel/memory/memory.hpp>
+#include <kernel/memory/physical.hpp>
+#include <kernel/memory/simd.hpp>
+#include <kernel/sched/thread.hpp>
+#include <kernel/time/clock.hpp>
+#endif
+
+namespace {
+/**
+ * @details `sysretq` loads the user stack segment from the selector in bits 48 to 63 plus 8 and
+ * the user code segment from it plus 16, `syscall` the kernel code segment from bits 32 to 47 and
+ * the kernel stack segment from it plus 8.
+ */
+constexpr uint64_t SYSCALL_STAR =
+    (static_cast<uint64_t>((USER_DATA_SELECTOR - 8) | SELECTOR_RPL_USER) << 48) |
+    (static_cast<uint64_t>(KERNEL_CODE_SELECTOR) << 32);
+
+/**
+ * @details Interrupts stay disabled until the entry code switched to the kernel stack, and the
+ * kernel never runs with the user's direction, alignment check, trap or I/O privilege flags.
+ */
+constexpr uint64_t SYSCALL_FLAGS_MASK =
+    FLAGS_IF | FLAGS_TF | FLAGS_DF | FLAGS_AC | FLAGS_NT | FLAGS_IOPL_MASK;
+}  // namespace
+
+void syscall_initialize() {
+  if (!test_feature(FEATURE_SYSCALL)) {
+    log_warn("SYSCALL is not supported, system calls are not available.");
+    return;
+  }
+
+  write_msr(MSR_STAR, SYSCALL_STAR);
+  write_msr(MSR_LSTAR, reinterpret_cast<uintptr_t>(syscall_entry));
+  write_msr(MSR_FMASK, SYSCALL_FLAGS_MASK);
+  write_msr(MSR_EFER, read_msr(MSR_EFER) | EFER_SCE);
+}
+
+#ifdef ENABLE_BENCHMARKS
+
+extern "C" const uint8_t syscall_benchmark_code[];
+extern "C" const uint8_t syscall_benchmark_code_end[];
+extern "C" const uint8_t syscall_fpu_fill_code[];
+extern "C" const uint8_t syscall_fpu_check_code[];
+
+namespace {
+constexpr uintptr_t BENCHMARK_CODE = 0x00007f0000000000ul;  ///< User address of the code page.
+constexpr uintptr_t BENCHMARK_STACK = BENCHMARK_CODE + 2 * PAGE_SIZE_4KiB;  ///< Stack page.
+constexpr uint64_t BENCHMARK_WARMUP = 1000;  ///< Calls made before measuring.
+constexpr uint64_t FPU_CHECK_PATTERN = 0x5a5ac3c30f0f9696ul;  ///< Value of the user registers.
+
+/// @brief Returns the user address of `code`, which lies in the copied benchmark code.
+uintptr_t user_address(const uint8_t* code) {
+  return BENCHMARK_CODE + static_cast<uintptr_t>(code - syscall_benchmark_code);
+}
+
+/**
+ * @brief Checks that the user registers survive a kernel FPU section between two entries to user
+ * mode.
+ * @details The pages of an allocation of `ZERO_STREAM_MIN_SIZE` bytes are zeroed with SSE2 stores,
+ * as they would be in a system call. The section must save the registers the first entry left and
+ * the return to user mode must load them again.
+ */
+void fpu_check(uintptr_t stack_top) {
+  user_enter(user_address(syscall_fpu_fill_code), stack_top, FPU_CHECK_PATTERN);
+
+  phys_allocator.free(phys_allocator.allocate(ZERO_STREAM_MIN_SIZE), ZERO_STREAM_MIN_SIZE);
+
+  const int64_t lost = user_enter(user_address(syscall_fpu_check_code), stack_top,
+                                  FPU_CHECK_PATTERN);
+
+  if (lost) {
+    log_error("%ld user XMM registers lost across a kernel FPU section.", lost);
+  }
+}
+}  // namespace
+
+/**
+ * @details The code runs on the executing processor in user mode, so every iteration crosses both
+ * privilege transitions. The pages stay mapped, the benchmark runs once per boot. The FPU check
+ * runs first, it needs the same user pages.
+ */
+void syscall_benchmark_run() {
+  if (!test_feature(FEATURE_SYSCALL)) {
+    return;
+  }
+
+  if (!thread_fpu_initialize()) {
+    log_error("No memory for the FPU state of the system call benchmark.");
+    return;
+  }
+
+  const uintptr_t code = phys_allocator.allocate(PAGE_SIZE_4KiB);
+  const uintptr_t stack = phys_allocator.allocate(PAGE_SIZE_4KiB);
+
+  memcpy(reinterpret_cast<void*>(to_higher_half(code)), syscall_benchmark_code,
+         syscall_benchmark_code_end - syscall_benchmark_code);
+
+  if (!map_user_page(BENCHMARK_CODE, code, 0) ||
+      !map_user_page(BENCHMARK_STACK, stack, PTE_WRITABLE | PTE_NO_EXECUTE)) {
+    log_error("Failed to map the system call benchmark.");
+    return;
+  }
+
+  const uintptr_t stack_top = BENCHMARK_STACK + PAGE_SIZE_4KiB;
+
+  fpu_check(stack_top);
+  user_enter(BENCHMARK_CODE, stack_top, BENCHMARK_WARMUP);
+
+  const uint64_t cycles = user_enter(BENCHMARK_CODE, stack_top, SYSCALL_BENCHMARK_ITERATIONS);
+  const uint64_t per_call = cycles / SYSCALL_BENCHMARK_ITERATIONS;
+
+  log_info("System call round trip, %d null calls: %lu cycles/call (%lu ns)",
+           SYSCALL_BENCHMARK_ITERATIONS, per_call, cycles_to_ns(per_call));
+}
+
+#endif  // ENABLE_BENCHMARKS
\ No newline at end of file
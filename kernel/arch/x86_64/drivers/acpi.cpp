@@ -0,0 +1,92 @@
+#include <klibc/string.h>
+#include <log.hpp>
+
+#include <kernel/kernel.h>
+
+#include <kernel/arch/x86_64/cpu/paging.hpp>
+#include <kernel/arch/x86_64/drivers/acpi.hpp>
+
+namespace {
+/**
+ * @brief Root System Description Pointer, the fields after `rsdt_address` exist from revision 2.
+ */
+struct Rsdp {
+  char signature[8];      ///< `RSD PTR `.
+  uint8_t checksum;       ///< Checksum of the first 20 bytes.
+  char oem_id[6];         ///< OEM identifier.
+  uint8_t revision;       ///< 0 for ACPI 1.0, 2 for later versions.
+  uint32_t rsdt_address;  ///< Physical address of the RSDT.
+  uint32_t length;        ///< Size of the structure.
+  uint64_t xsdt_address;  ///< Physical address of the XSDT.
+  uint8_t ext_checksum;   ///< Checksum of the whole structure.
+  uint8_t reserved[3];    ///< Reserved.
+} __PACKED;
+
+constexpr size_t RSDP_V1_SIZE = 20;  ///< Part of the RSDP covered by `checksum`.
+
+bool checksum_valid(const void* data, size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  uint8_t sum = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    sum += bytes[i];
+  }
+
+  return sum == 0;
+}
+
+/**
+ * @details The header is mapped first to learn the size of the table, then the whole table.
+ */
+const AcpiHeader* map_table(uintptr_t phys) {
+  const auto* header = static_cast<const AcpiHeader*>(map_firmware(phys, sizeof(AcpiHeader)));
+  map_firmware(phys, header->length);
+
+  return header;
+}
+}  // namespace
+
+/**
+ * @details Limine reports the RSDP by its physical address. The XSDT lists 64 bit addresses, the
+ * RSDT of revision 0 firmware 32 bit ones; entries are unaligned in the XSDT, so they are copied.
+ */
+const AcpiHeader* acpi_find_table(const char* signature) {
+  limine_rsdp_response* response = rsdp_request.response;
+
+  if (!response) {
+    return nullptr;
+  }
+
+  const auto* rsdp = static_cast<const Rsdp*>(map_firmware(response->address, sizeof(Rsdp)));
+
+  if (!checksum_valid(rsdp, RSDP_V1_SIZE)) {
+    log_error("ACPI RSDP checksum is invalid.");
+    return nullptr;
+  }
+
+  const bool xsdt = rsdp->revision >= 2 && rsdp->xsdt_address;
+  const AcpiHeader* root = map_table(xsdt ? rsdp->xsdt_address : rsdp->rsdt_address);
+  const size_t entry_size = xsdt ? sizeof(uint64_t) : sizeof(uint32_t);
+  const size_t count = (root->length - sizeof(AcpiHeader)) / entry_size;
+  const auto* entries = reinterpret_cast<const uint8_t*>(root + 1);
+
+  for (size_t i = 0; i < count; i++) {
+    uint64_t address = 0;
+    memcpy(&address, entries + i * entry_size, entry_size);
+
+    const AcpiHeader* table = map_table(address);
+
+    if (memcmp(table->signature, signature, sizeof(table->signature)) != 0) {
+      continue;
+    }
+
+    if (!checksum_valid(table, table->length)) {
+      log_warn("ACPI table %.4s has an invalid checksum.", signature);
+      continue;
+    }
+
+    return table;
+  }
+
+  return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef KERNEL_DRIVERS_INTERNAL_IOAPIC_H
+#define KERNEL_DRIVERS_INTERNAL_IOAPIC_H 1
+
+#define IOAPIC_MMIO_SIZE 0x20
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WINDOW 0x10
+
+#define IOAPIC_REG_VERSION 0x01
+#define IOAPIC_REG_REDIRECTION 0x10
+
+#define IOAPIC_VERSION_MAX_ENTRY_SHIFT 16u
+#define IOAPIC_VERSION_MAX_ENTRY_MASK 0xffu
+
+#define IOAPIC_ENTRY_ACTIVE_LOW (1u << 13u)
+#define IOAPIC_ENTRY_LEVEL (1u << 15u)
+#define IOAPIC_ENTRY_MASKED (1u << 16u)
+#define IOAPIC_DESTINATION_SHIFT 24u
+
+#define PIC1_DATA 0x21
+#define PIC2_DATA 0xa1
+#define PIC_MASK_ALL 0xffu
+
+#endif  // KERNEL_DRIVERS_INTERNAL_IOAPIC_H
\ No newline at end of file
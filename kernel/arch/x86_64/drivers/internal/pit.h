@@ -0,0 +1,16 @@
+#ifndef KERNEL_DRIVERS_INTERNAL_PIT_H
+#define KERNEL_DRIVERS_INTERNAL_PIT_H 1
+
+#define PIT_CHANNEL2 0x42
+#define PIT_COMMAND 0x43
+#define PIT_GATE 0x61
+
+#define PIT_COMMAND_CHANNEL2 (2u << 6u)
+#define PIT_COMMAND_LOHI (3u << 4u)
+#define PIT_COMMAND_MODE0 (0u << 1u)
+
+#define PIT_GATE_CHANNEL2 (1u << 0u)
+#define PIT_GATE_SPEAKER (1u << 1u)
+#define PIT_GATE_CHANNEL2_OUT (1u << 5u)
+
+#endif  // KERNEL_DRIVERS_INTERNAL_PIT_H
\ No newline at end of file
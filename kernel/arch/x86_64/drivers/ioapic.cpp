@@ -0,0 +1,284 @@
+#include "internal/ioapic.h"
+
+#include <log.hpp>
+
+#include <kernel/arch/x86_64/arch.hpp>
+#include <kernel/arch/x86_64/cpu/paging.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/arch/x86_64/drivers/acpi.hpp>
+#include <kernel/arch/x86_64/drivers/ioapic.hpp>
+#include <kernel/sync/irq.hpp>
+#include <lock.hpp>
+
+namespace {
+/**
+ * @brief One I/O APIC and the range of GSIs it serves.
+ */
+struct Ioapic {
+  volatile uint32_t* mmio;  ///< Index and data register.
+  uint32_t gsi_base;        ///< GSI of input 0.
+  uint32_t count;           ///< Number of inputs.
+};
+
+/**
+ * @brief Routing of one GSI, `vector` is 0 while it is not routed.
+ */
+struct IoapicLine {
+  uint8_t vector;  ///< Vector the GSI raises.
+  bool masked;     ///< Delivery is stopped by `ioapic_mask`.
+  uint32_t mode;   ///< `IOAPIC_*` input mode.
+  uint32_t cpu;    ///< Index of the processor the GSI is delivered to.
+};
+
+/**
+ * @brief Connection of an ISA IRQ, identity mapped and edge triggered unless overridden.
+ */
+struct IsaIrq {
+  uint32_t gsi;   ///< GSI the IRQ is connected to.
+  uint32_t mode;  ///< `IOAPIC_*` input mode.
+};
+
+/**
+ * @details Serializes the index register of every I/O APIC and the routing table. Routing changes
+ * are rare and never on a hot path.
+ */
+TicketLock ioapic_lock;
+
+Ioapic controllers[IOAPIC_MAX_CONTROLLERS];
+uint32_t controller_count = 0;
+IoapicLine lines[IOAPIC_MAX_GSIS];
+IsaIrq isa_irqs[ISA_IRQ_COUNT];
+bool initialized = false;  ///< The I/O APICs were found and `isa_irqs` is filled.
+
+uint32_t read_reg(const Ioapic& ioapic, uint32_t reg) {
+  ioapic.mmio[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+  return ioapic.mmio[IOAPIC_WINDOW / sizeof(uint32_t)];
+}
+
+void write_reg(const Ioapic& ioapic, uint32_t reg, uint32_t value) {
+  ioapic.mmio[IOAPIC_REGSEL / sizeof(uint32_t)] = reg;
+  ioapic.mmio[IOAPIC_WINDOW / sizeof(uint32_t)] = value;
+}
+
+/// @brief Returns the I/O APIC serving `gsi`, `nullptr` if there is none.
+const Ioapic* find_controller(uint32_t gsi) {
+  for (uint32_t i = 0; i < controller_count; i++) {
+    if (gsi >= controllers[i].gsi_base && gsi - controllers[i].gsi_base < controllers[i].count) {
+      return &controllers[i];
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+ * @details Destinations are 8 bit local APIC IDs in physical mode, processors with larger x2APIC
+ * IDs need interrupt remapping, which the kernel does not set up.
+ */
+bool addressable(uint32_t cpu) { return cpu < cpu_count() && cpu_data(cpu)->lapic_id <= 0xff; }
+
+/**
+ * @details The destination is written first, so an unmasked entry never points at a stale
+ * processor. Changing only the destination is a single write of the upper half.
+ */
+void program(uint32_t gsi, bool destination_only) {
+  const Ioapic* ioapic = find_controller(gsi);
+  const IoapicLine& line = lines[gsi];
+  const uint32_t reg = IOAPIC_REG_REDIRECTION + 2 * (gsi - ioapic->gsi_base);
+
+  write_reg(*ioapic, reg + 1, cpu_data(line.cpu)->lapic_id << IOAPIC_DESTINATION_SHIFT);
+
+  if (destination_only) {
+    return;
+  }
+
+  uint32_t low = line.vector;
+
+  if (line.mode & IOAPIC_ACTIVE_LOW) {
+    low |= IOAPIC_ENTRY_ACTIVE_LOW;
+  }
+
+  if (line.mode & IOAPIC_LEVEL) {
+    low |= IOAPIC_ENTRY_LEVEL;
+  }
+
+  if (line.masked || !line.vector) {
+    low |= IOAPIC_ENTRY_MASKED;
+  }
+
+  write_reg(*ioapic, reg, low);
+}
+
+void add_controller(const MadtIoapic* entry) {
+  if (controller_count == IOAPIC_MAX_CONTROLLERS) {
+    log_warn("Ignoring I/O APIC %u, only %d are supported.", entry->id, IOAPIC_MAX_CONTROLLERS);
+    return;
+  }
+
+  Ioapic& ioapic = controllers[controller_count++];
+  ioapic.mmio = static_cast<volatile uint32_t*>(map_mmio(entry->address, IOAPIC_MMIO_SIZE));
+  ioapic.gsi_base = entry->gsi_base;
+
+  const uint32_t version = read_reg(ioapic, IOAPIC_REG_VERSION);
+  ioapic.count =
+      ((version >> IOAPIC_VERSION_MAX_ENTRY_SHIFT) & IOAPIC_VERSION_MAX_ENTRY_MASK) + 1;
+
+  for (uint32_t i = 0; i < ioapic.count; i++) {
+    write_reg(ioapic, IOAPIC_REG_REDIRECTION + 2 * i, IOAPIC_ENTRY_MASKED);
+  }
+
+  log_info("I/O APIC %u at %#x serves GSIs %u-%u.", entry->id, entry->address, ioapic.gsi_base,
+           ioapic.gsi_base + ioapic.count - 1);
+}
+
+/**
+ * @details Polarity and trigger mode fields that conform to the bus keep the ISA defaults.
+ */
+void add_override(const MadtSourceOverride* entry) {
+  if (entry->bus != 0 || entry->source >= ISA_IRQ_COUNT) {
+    return;
+  }
+
+  uint32_t mode = 0;
+
+  if ((entry->flags & MPS_POLARITY_MASK) == MPS_POLARITY_LOW) {
+    mode |= IOAPIC_ACTIVE_LOW;
+  }
+
+  if ((entry->flags & MPS_TRIGGER_MASK) == MPS_TRIGGER_LEVEL) {
+    mode |= IOAPIC_LEVEL;
+  }
+
+  isa_irqs[entry->source] = {entry->gsi, mode};
+  log_debug("ISA IRQ %u is GSI %u%s%s.", entry->source, entry->gsi,
+            mode & IOAPIC_LEVEL ? ", level triggered" : "",
+            mode & IOAPIC_ACTIVE_LOW ? ", active low" : "");
+}
+}  // namespace
+
+bool ioapic_initialize() {
+  for (uint32_t irq = 0; irq < ISA_IRQ_COUNT; irq++) {
+    isa_irqs[irq] = {irq, 0};
+  }
+
+  const auto* madt = reinterpret_cast<const Madt*>(acpi_find_table(ACPI_SIGNATURE_MADT));
+
+  if (!madt) {
+    log_warn("No MADT, device interrupts are not routed.");
+    return false;
+  }
+
+  const auto* cursor = reinterpret_cast<const uint8_t*>(madt + 1);
+  const auto* end = reinterpret_cast<const uint8_t*>(madt) + madt->header.length;
+
+  while (cursor + sizeof(MadtEntry) <= end) {
+    const auto* entry = reinterpret_cast<const MadtEntry*>(cursor);
+
+    if (entry->length < sizeof(MadtEntry) || cursor + entry->length > end) {
+      break;
+    }
+
+    if (entry->type == MADT_IOAPIC) {
+      add_controller(reinterpret_cast<const MadtIoapic*>(entry));
+    } else if (entry->type == MADT_SOURCE_OVERRIDE) {
+      add_override(reinterpret_cast<const MadtSourceOverride*>(entry));
+    }
+
+    cursor += entry->length;
+  }
+
+  if (!controller_count) {
+    log_warn("The MADT lists no I/O APIC, device interrupts are not routed.");
+    return false;
+  }
+
+  if (madt->flags & MADT_PCAT_COMPAT) {
+    outp<uint8_t>(PIC1_DATA, PIC_MASK_ALL);
+    outp<uint8_t>(PIC2_DATA, PIC_MASK_ALL);
+  }
+
+  initialized = true;
+  return true;
+}
+
+uint32_t ioapic_isa_gsi(uint8_t irq) {
+  return initialized && irq < ISA_IRQ_COUNT ? isa_irqs[irq].gsi : irq;
+}
+
+uint8_t ioapic_route(uint32_t gsi, uint32_t mode, uint32_t cpu, InterruptHandler handler,
+                     void* data) {
+  IrqSpinGuard guard(ioapic_lock);
+
+  if (gsi >= IOAPIC_MAX_GSIS || !find_controller(gsi) || lines[gsi].vector || !addressable(cpu)) {
+    return 0;
+  }
+
+  const uint8_t vector = interrupt_allocate(handler, data);
+
+  if (!vector) {
+    log_error("No free vector for GSI %u.", gsi);
+    return 0;
+  }
+
+  lines[gsi] = {vector, false, mode, cpu};
+  program(gsi, false);
+
+  return vector;
+}
+
+uint8_t ioapic_route_isa(uint8_t irq, uint32_t cpu, InterruptHandler handler, void* data) {
+  if (irq >= ISA_IRQ_COUNT || !initialized) {
+    return 0;
+  }
+
+  return ioapic_route(isa_irqs[irq].gsi, isa_irqs[irq].mode, cpu, handler, data);
+}
+
+bool ioapic_set_affinity(uint32_t gsi, uint32_t cpu) {
+  IrqSpinGuard guard(ioapic_lock);
+
+  if (gsi >= IOAPIC_MAX_GSIS || !lines[gsi].vector || !addressable(cpu)) {
+    return false;
+  }
+
+  lines[gsi].cpu = cpu;
+  program(gsi, true);
+
+  return true;
+}
+
+void ioapic_mask(uint32_t gsi) {
+  IrqSpinGuard guard(ioapic_lock);
+
+  if (gsi < IOAPIC_MAX_GSIS && lines[gsi].vector) {
+    lines[gsi].masked = true;
+    program(gsi, false);
+  }
+}
+
+void ioapic_unmask(uint32_t gsi) {
+  IrqSpinGuard guard(ioapic_lock);
+
+  if (gsi < IOAPIC_MAX_GSIS && lines[gsi].vector) {
+    lines[gsi].masked = false;
+    program(gsi, false);
+  }
+}
+
+/**
+ * @details The entry is masked before the vector is freed, so the vector cannot be raised once it
+ * was handed out again.
+ */
+void ioapic_release(uint32_t gsi) {
+  IrqSpinGuard guard(ioapic_lock);
+
+  if (gsi >= IOAPIC_MAX_GSIS || !lines[gsi].vector) {
+    return;
+  }
+
+  const uint8_t vector = lines[gsi].vector;
+
+  lines[gsi].vector = 0;
+  program(gsi, false);
+  interrupt_unregister(vector);
+}
\ No newline at end of file
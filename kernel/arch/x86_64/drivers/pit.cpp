@@ -0,0 +1,30 @@
+#include "internal/pit.h"
+
+#include <kernel/arch/x86_64/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/drivers/pit.hpp>
+
+/**
+ * @details Mode 0 raises the channel output once the counter reaches zero. The gate is enabled
+ * with the speaker disconnected before the count is loaded, which starts the countdown.
+ */
+uint64_t pit_measure_tsc(uint32_t ms) {
+  const uint16_t count = static_cast<uint16_t>(PIT_FREQUENCY * ms / 1000);
+  const uint8_t gate = inp<uint8_t>(PIT_GATE);
+
+  outp<uint8_t>(PIT_GATE, (gate & ~PIT_GATE_SPEAKER) | PIT_GATE_CHANNEL2);
+  outp<uint8_t>(PIT_COMMAND, PIT_COMMAND_CHANNEL2 | PIT_COMMAND_LOHI | PIT_COMMAND_MODE0);
+  outp<uint8_t>(PIT_CHANNEL2, count & 0xff);
+  outp<uint8_t>(PIT_CHANNEL2, count >> 8);
+
+  const uint64_t start = rdtsc();
+
+  while (!(inp<uint8_t>(PIT_GATE) & PIT_GATE_CHANNEL2_OUT)) {
+    arch_pause();
+  }
+
+  const uint64_t cycles = rdtsc() - start;
+  outp<uint8_t>(PIT_GATE, gate);
+
+  return cycles;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <log.hpp>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/idt.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/irq/latency.hpp>
+#include <kernel/time/clock.hpp>
+
+namespace {
+/**
+ * @brief Latency state of one processor, only written by that processor with interrupts disabled.
+ */
+struct alignas(CACHE_LINE_SIZE) LatencyCpu {
+  uint64_t irqsoff_start;  ///< Timestamp the current section started, 0 outside of one.
+  uintptr_t irqsoff_ip;    ///< Instruction that started the current section.
+  uint64_t irqsoff_max;    ///< Longest section so far, in cycles.
+  uintptr_t irqsoff_max_ip;
+  uint32_t histograms[MAX_IDT_ENTRIES][IRQ_LATENCY_BUCKETS];
+};
+
+LatencyCpu latency_cpus[MAX_CPUS];
+
+/// @brief Returns the bucket of `cycles`, bucket `n` holds `[2^n, 2^(n+1))`.
+uint32_t bucket(uint64_t cycles) {
+  const uint32_t order = cycles ? 63 - __builtin_clzl(cycles) : 0;
+  return order < IRQ_LATENCY_BUCKETS ? order : IRQ_LATENCY_BUCKETS - 1;
+}
+
+void dump_histogram(uint32_t vector) {
+  uint64_t counts[IRQ_LATENCY_BUCKETS] = {};
+  uint64_t total = 0;
+
+  for (uint32_t i = 0; i < cpu_count(); i++) {
+    for (uint32_t j = 0; j < IRQ_LATENCY_BUCKETS; j++) {
+      counts[j] += __atomic_load_n(&latency_cpus[i].histograms[vector][j], __ATOMIC_RELAXED);
+    }
+  }
+
+  for (uint32_t j = 0; j < IRQ_LATENCY_BUCKETS; j++) {
+    total += counts[j];
+  }
+
+  if (!total) {
+    return;
+  }
+
+  log_info("  vector %u, %lu interrupts:", vector, total);
+
+  for (uint32_t j = 0; j < IRQ_LATENCY_BUCKETS; j++) {
+    if (counts[j]) {
+      log_info("    >= %lu ns (2^%u cycles): %lu", cycles_to_ns(1ul << j), j, counts[j]);
+    }
+  }
+}
+}  // namespace
+
+extern "C" void irq_latency_record(uint64_t vector, uint64_t cycles) {
+  latency_cpus[arch_cpu_index()].histograms[vector][bucket(cycles)]++;
+}
+
+void irqsoff_begin(uintptr_t ip) {
+  LatencyCpu& cpu = latency_cpus[arch_cpu_index()];
+
+  cpu.irqsoff_ip = ip;
+  cpu.irqsoff_start = rdtsc();
+}
+
+/**
+ * @details Sections that began before the instrumentation saw them, e.g. interrupts disabled by
+ * the boot code, have no start and are ignored.
+ */
+void irqsoff_end() {
+  LatencyCpu& cpu = latency_cpus[arch_cpu_index()];
+
+  if (!cpu.irqsoff_start) {
+    return;
+  }
+
+  const uint64_t cycles = rdtsc() - cpu.irqsoff_start;
+  cpu.irqsoff_start = 0;
+
+  if (cycles > cpu.irqsoff_max) {
+    cpu.irqsoff_max = cycles;
+    cpu.irqsoff_max_ip = cpu.irqsoff_ip;
+  }
+}
+
+void irq_latency_dump() {
+  log_info("Interrupt handler latency by vector:");
+
+  for (uint32_t vector = 0; vector < MAX_IDT_ENTRIES; vector++) {
+    dump_histogram(vector);
+  }
+
+  log_info("Longest interrupts-off sections:");
+
+  for (uint32_t i = 0; i < cpu_count(); i++) {
+    const LatencyCpu& cpu = latency_cpus[i];
+
+    if (cpu.irqsoff_max) {
+      log_info("  cpu %u: %lu cycles (%lu ns) disabled at %p", i, cpu.irqsoff_max,
+               cycles_to_ns(cpu.irqsoff_max), reinterpret_cast<void*>(cpu.irqsoff_max_ip));
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/irq/softirq.hpp>
+
+static_assert(SOFTIRQ_COUNT <= 32, "Pending software interrupts are a 32 bit mask");
+
+namespace {
+SoftirqHandler handlers[SOFTIRQ_COUNT];
+
+/**
+ * @brief Tasklets scheduled on one processor, only touched by it with interrupts disabled.
+ */
+struct alignas(CACHE_LINE_SIZE) TaskletQueue {
+  Tasklet* head;
+  Tasklet* tail;
+};
+
+TaskletQueue tasklet_queues[MAX_CPUS];
+
+void enqueue(Tasklet* tasklet) {
+  TaskletQueue& queue = tasklet_queues[arch_cpu_index()];
+
+  tasklet->next = nullptr;
+
+  if (queue.tail) {
+    queue.tail->next = tasklet;
+  } else {
+    queue.head = tasklet;
+  }
+
+  queue.tail = tasklet;
+  softirq_raise(SOFTIRQ_TASKLET);
+}
+
+/**
+ * @details Takes the whole queue at once. A tasklet that still runs on another processor is queued
+ * again and retried in the next round, so it never runs twice at the same time.
+ */
+void tasklet_softirq() {
+  uint64_t flags = arch_interrupt_save();
+  TaskletQueue& queue = tasklet_queues[arch_cpu_index()];
+  Tasklet* list = queue.head;
+
+  queue.head = nullptr;
+  queue.tail = nullptr;
+  arch_interrupt_restore(flags);
+
+  while (list) {
+    Tasklet* tasklet = list;
+    list = tasklet->next;
+
+    if (tasklet->state.fetch_or(TASKLET_RUNNING, std::memory_order_acquire) & TASKLET_RUNNING) {
+      flags = arch_interrupt_save();
+      enqueue(tasklet);
+      arch_interrupt_restore(flags);
+      continue;
+    }
+
+    tasklet->state.fetch_and(~TASKLET_SCHEDULED, std::memory_order_relaxed);
+    tasklet->function(tasklet);
+    tasklet->state.fetch_and(~TASKLET_RUNNING, std::memory_order_release);
+  }
+}
+}  // namespace
+
+void softirq_initialize() { softirq_register(SOFTIRQ_TASKLET, tasklet_softirq); }
+
+void softirq_register(SoftirqType type, SoftirqHandler handler) { handlers[type] = handler; }
+
+void softirq_raise(SoftirqType type) {
+  const uint64_t flags = arch_interrupt_save();
+  this_cpu_write(softirq_pending, this_cpu_read(softirq_pending) | (1u << type));
+  arch_interrupt_restore(flags);
+}
+
+bool softirq_pending() { return this_cpu_read(softirq_pending) != 0; }
+
+/**
+ * @details Handlers raised while a round runs are picked up by the next round. After
+ * `SOFTIRQ_MAX_RESTARTS` rounds the rest stays pending for the idle loop, so a flood of interrupts
+ * cannot keep the interrupted code from making progress.
+ */
+void softirq_run() {
+  if (this_cpu_read(softirq_depth)) {
+    return;
+  }
+
+  this_cpu_write(softirq_depth, 1u);
+
+  for (size_t round = 0; round < SOFTIRQ_MAX_RESTARTS; round++) {
+    uint32_t pending = this_cpu_read(softirq_pending);
+
+    if (!pending) {
+      break;
+    }
+
+    this_cpu_write(softirq_pending, 0u);
+    arch_enable_interrupts();
+
+    for (; pending; pending &= pending - 1) {
+      handlers[__builtin_ctz(pending)]();
+    }
+
+    arch_disable_interrupts();
+  }
+
+  this_cpu_write(softirq_depth, 0u);
+}
+
+void softirq_disable() {
+  const uint64_t flags = arch_interrupt_save();
+  this_cpu_write(softirq_depth, this_cpu_read(softirq_depth) + 1);
+  arch_interrupt_restore(flags);
+}
+
+/**
+ * @details Pending software interrupts only run if interrupts were enabled, since their handlers
+ * enable interrupts.
+ */
+void softirq_enable() {
+  const uint64_t flags = arch_interrupt_save();
+  const uint32_t depth = this_cpu_read(softirq_depth) - 1;
+
+  this_cpu_write(softirq_depth, depth);
+
+  if (depth == 0 && (flags & ARCH_FLAGS_IF)) {
+    softirq_run();
+  }
+
+  arch_interrupt_restore(flags);
+}
+
+void tasklet_schedule(Tasklet* tasklet) {
+  if (tasklet->state.fetch_or(TASKLET_SCHEDULED, std::memory_order_acq_rel) & TASKLET_SCHEDULED) {
+    return;
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+  enqueue(tasklet);
+  arch_interrupt_restore(flags);
+}
\ No newline at end of file
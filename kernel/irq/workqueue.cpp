@@ -0,0 +1,129 @@
+#include <log.hpp>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/irq/workqueue.hpp>
+#include <kernel/sched/thread.hpp>
+#include <kernel/sync/irq.hpp>
+#include <lock.hpp>
+
+namespace {
+/**
+ * @brief Work queued on one processor, items may be added from any processor.
+ */
+struct alignas(CACHE_LINE_SIZE) WorkQueue {
+  TicketLock lock;
+  Work* head;
+  Work* tail;
+  Thread* worker;  ///< Thread draining the queue, `nullptr` until it was started.
+};
+
+WorkQueue queues[MAX_CPUS];
+
+void append(WorkQueue& queue, Work* work) {
+  IrqSpinGuard guard(queue.lock);
+
+  work->next = nullptr;
+
+  if (queue.tail) {
+    queue.tail->next = work;
+  } else {
+    queue.head = work;
+  }
+
+  queue.tail = work;
+}
+
+/**
+ * @brief Runs the work queued on `queue` until it is empty.
+ * @details The pending flag is cleared before an item runs, so it can queue itself again.
+ */
+void drain(WorkQueue& queue) {
+  while (true) {
+    Work* batch;
+
+    {
+      IrqSpinGuard guard(queue.lock);
+      batch = queue.head;
+      queue.head = nullptr;
+      queue.tail = nullptr;
+    }
+
+    if (!batch) {
+      return;
+    }
+
+    while (batch) {
+      Work* work = batch;
+      batch = work->next;
+
+      work->pending.store(false, std::memory_order_release);
+      work->function(work);
+    }
+
+    thread_yield();
+  }
+}
+
+/**
+ * @details An item queued after the queue was found empty wakes the worker before it blocks, which
+ * makes `thread_block` return at once. Yielding between batches keeps a queue that refills itself
+ * from starving the other threads of the processor.
+ */
+void worker_main(void* arg) {
+  auto* queue = static_cast<WorkQueue*>(arg);
+
+  while (true) {
+    drain(*queue);
+    thread_block();
+  }
+}
+}  // namespace
+
+bool work_queue(Work* work) {
+  const uint64_t flags = arch_interrupt_save();
+  const bool queued = work_queue_on(arch_cpu_index(), work);
+
+  arch_interrupt_restore(flags);
+  return queued;
+}
+
+bool work_queue_on(uint32_t cpu, Work* work) {
+  if (work->pending.exchange(true, std::memory_order_acq_rel)) {
+    return false;
+  }
+
+  WorkQueue& queue = queues[cpu];
+  append(queue, work);
+
+  Thread* worker = __atomic_load_n(&queue.worker, __ATOMIC_ACQUIRE);
+
+  if (worker) {
+    thread_wake(worker);
+  }
+
+  return true;
+}
+
+/**
+ * @details A worker is published once it was started, then woken once for the items queued before
+ * `work_queue_on` could see it.
+ */
+void workqueue_initialize() {
+  for (uint32_t cpu = 0; cpu < cpu_count(); cpu++) {
+    if (!cpu_data(cpu)->online.load(std::memory_order_acquire)) {
+      continue;
+    }
+
+    WorkQueue& queue = queues[cpu];
+    Thread* worker = thread_create(worker_main, &queue, "worker");
+
+    if (!worker) {
+      log_panic("Failed to create the worker of processor %u.", cpu);
+    }
+
+    thread_start(worker, cpu);
+    __atomic_store_n(&queue.worker, worker, __ATOMIC_RELEASE);
+    thread_wake(worker);
+  }
+}
\ No newline at end of file
@@ -47,4 +47,19 @@ volatile struct limine_executable_file_request kernel_file_request = {
   .response = nullptr,
 };
 
+__SECTION(".limine_requests")
+volatile struct limine_mp_request mp_request = {
+  .id = LIMINE_MP_REQUEST,
+  .revision = 0,
+  .response = nullptr,
+  .flags = 0,
+};
+
+__SECTION(".limine_requests")
+volatile struct limine_rsdp_request rsdp_request = {
+  .id = LIMINE_RSDP_REQUEST,
+  .revision = 0,
+  .response = nullptr,
+};
+
 __SECTION(".limine_requests_end_marker") __USED static volatile LIMINE_REQUESTS_END_MARKER;
\ No newline at end of file
@@ -1,21 +1,49 @@
 #include <klibc/stdio.h>
 
 #include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/idle.hpp>
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+#include <kernel/arch/x86_64/cpu/syscall.hpp>
+#include <kernel/arch/x86_64/drivers/ioapic.hpp>
+#include <kernel/irq/latency.hpp>
+#include <kernel/irq/softirq.hpp>
+#include <kernel/irq/workqueue.hpp>
+#include <kernel/memory/boot.hpp>
 #include <kernel/memory/physical.hpp>
+#include <kernel/memory/profiler.hpp>
+#include <kernel/memory/slab.hpp>
+#include <kernel/sched/thread.hpp>
+#include <kernel/sync/benchmark.hpp>
+#include <kernel/sync/lockstat.hpp>
+#include <kernel/time/clock.hpp>
+#include <kernel/time/timer.hpp>
 #include <log.hpp>
 
-namespace {
-PhysicalAllocator phys_allocator;
-}
-
 extern "C" void kmain() {
   log::set_level(LOG_TRACE);
   log::set_quiet(false);
 
   arch_initialize();
+  clock_initialize();
+  softirq_initialize();
+  idle_initialize();
+  timer_initialize();
   phys_allocator.initialize();
+  kmem_initialize();
+  boot_arena_handover();
+  arch_smp_initialize();
+  workqueue_initialize();
+  ioapic_initialize();
+  sync_benchmark_run();
+  syscall_benchmark_run();
+  thread_benchmark_run();
 
   log_info("Hello, World!");
 
+  alloc_profiler_dump();
+  lockstat_dump();
+  interrupt_dump();
+  irq_latency_dump();
+
   arch_halt(true);
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <log.hpp>
+
+#include <span>
+
+#include <kernel/kernel.h>
+
+#include <kernel/memory/boot.hpp>
+#include <kernel/memory/memory.hpp>
+#include <kernel/memory/physical.hpp>
+
+namespace {
+struct BootChunk {
+  uint8_t* base;  ///< Start of the region.
+  size_t size;    ///< Size of the region in bytes.
+  size_t used;    ///< Bytes handed out from the start of the region.
+};
+
+alignas(PAGE_SIZE_4KiB) uint8_t static_region[BOOT_ARENA_STATIC_SIZE];
+
+BootChunk chunks[BOOT_ARENA_MAX_CHUNKS] = {{static_region, BOOT_ARENA_STATIC_SIZE, 0}};
+size_t chunk_count = 1;
+size_t current = 0;
+
+uintptr_t carved_start = 0;  ///< Start of the memory carved off the memory map.
+uintptr_t carved_end = 0;    ///< End of the memory carved off the memory map.
+bool handed_over = false;
+
+/**
+ * @details Chunks are always taken from the start of the same memory map entry, so together they
+ * form one contiguous range and `boot_arena_owns` needs only two range checks before handover.
+ */
+BootChunk* carve_chunk() {
+  if (chunk_count == BOOT_ARENA_MAX_CHUNKS) {
+    return nullptr;
+  }
+
+  std::span<limine_memmap_entry*> memmaps(memmap_request.response->entries,
+                                          memmap_request.response->entry_count);
+
+  for (auto memmap : memmaps) {
+    if (memmap->type != LIMINE_MEMMAP_USABLE) {
+      continue;
+    }
+
+    if (carved_start && to_higher_half(memmap->base) != carved_end) {
+      continue;
+    }
+
+    if (memmap->length < BOOT_ARENA_CHUNK_SIZE) {
+      return nullptr;
+    }
+
+    const uintptr_t base = to_higher_half(memmap->base);
+
+    memmap->base += BOOT_ARENA_CHUNK_SIZE;
+    memmap->length -= BOOT_ARENA_CHUNK_SIZE;
+
+    if (!carved_start) {
+      carved_start = base;
+    }
+
+    carved_end = base + BOOT_ARENA_CHUNK_SIZE;
+
+    BootChunk* chunk = &chunks[chunk_count++];
+    chunk->base = reinterpret_cast<uint8_t*>(base);
+    chunk->size = BOOT_ARENA_CHUNK_SIZE;
+    chunk->used = 0;
+
+    return chunk;
+  }
+
+  return nullptr;
+}
+
+uintptr_t bump(BootChunk* chunk, size_t size, size_t align) {
+  const uintptr_t base = reinterpret_cast<uintptr_t>(chunk->base);
+  const uintptr_t start = align_up(base + chunk->used, align);
+
+  if (start + size > base + chunk->size) {
+    return 0;
+  }
+
+  chunk->used = start + size - base;
+  return start;
+}
+}  // namespace
+
+/**
+ * @details Allocations that do not fit into the current region move on to the next one, reusing a
+ * chunk freed by `boot_arena_release` before carving a new one. The tail of the old region is left
+ * unused.
+ */
+void* boot_alloc(size_t size, size_t align) {
+  if (handed_over) {
+    log_error("Boot arena allocation of %lu bytes after handover.", size);
+    return nullptr;
+  }
+
+  if (size == 0) {
+    return nullptr;
+  }
+
+  uintptr_t ptr = bump(&chunks[current], size, align);
+
+  if (!ptr) {
+    BootChunk* chunk = current + 1 < chunk_count ? &chunks[current + 1] : carve_chunk();
+
+    if (!chunk || !(ptr = bump(chunk, size, align))) {
+      log_error("Boot arena exhausted allocating %lu bytes.", size);
+      return nullptr;
+    }
+
+    current++;
+  }
+
+  return reinterpret_cast<void*>(ptr);
+}
+
+BootArenaMark boot_arena_mark() { return {current, chunks[current].used}; }
+
+void boot_arena_release(const BootArenaMark& mark) {
+  if (handed_over) {
+    return;
+  }
+
+  for (size_t i = mark.chunk + 1; i <= current; i++) {
+    chunks[i].used = 0;
+  }
+
+  current = mark.chunk;
+  chunks[current].used = mark.used;
+}
+
+/**
+ * @details After handover only the live prefix of each chunk is still owned, the rest belongs to
+ * the physical allocator and may hold slabs or large allocations that `kfree` must release.
+ */
+bool boot_arena_owns(const void* ptr) {
+  const auto addr = reinterpret_cast<uintptr_t>(ptr);
+  const auto region = reinterpret_cast<uintptr_t>(static_region);
+
+  if (addr - region < BOOT_ARENA_STATIC_SIZE) {
+    return true;
+  }
+
+  if (addr < carved_start || addr >= carved_end) {
+    return false;
+  }
+
+  if (!handed_over) {
+    return true;
+  }
+
+  for (size_t i = 1; i < chunk_count; i++) {
+    if (addr - reinterpret_cast<uintptr_t>(chunks[i].base) < chunks[i].size) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @details The static region is part of the kernel image and stays reserved. Of every carved chunk
+ * the pages holding live allocations are adopted as used memory and the remaining pages as free.
+ * Each chunk then shrinks to its live pages, the range `boot_arena_owns` keeps claiming.
+ */
+void boot_arena_handover() {
+  size_t live = 0;
+  size_t returned = 0;
+
+  for (size_t i = 1; i < chunk_count; i++) {
+    BootChunk& chunk = chunks[i];
+    const size_t used = align_up(chunk.used, static_cast<size_t>(PAGE_SIZE_4KiB));
+
+    phys_allocator.adopt(from_higher_half(reinterpret_cast<uintptr_t>(chunk.base)), chunk.size,
+                         used);
+
+    live += used;
+    returned += chunk.size - used;
+    chunk.size = used;
+  }
+
+  handed_over = true;
+
+  log_debug("Boot arena handed over: %lu KB static, %lu KB live, %lu KB returned",
+            to_KB(chunks[0].used), to_KB(live), to_KB(returned));
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include <log.hpp>
+
+#include <new>
+
+#include <kernel/memory/slab.hpp>
+
+namespace {
+/**
+ * @details Zero sized requests still have to return a unique pointer, so they take the smallest
+ * size class. Alignments up to the default are met by every size class already. Every form of
+ * `operator new` passes its own return address as `caller`, so the allocation profiler attributes
+ * the memory to the code using `new` rather than to this file.
+ */
+void* try_allocate(size_t size, size_t align, void* caller) {
+  align = align > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? align : 1;
+  return kmalloc_caller(size ? size : 1, align, caller);
+}
+
+/**
+ * @details Exceptions are disabled, so the throwing forms of `operator new` panic when the heap is
+ * exhausted instead of throwing `std::bad_alloc`. Alignments the heap rejects outright panic with
+ * a message of their own, so they are not mistaken for exhaustion.
+ */
+void* allocate(size_t size, size_t align, void* caller) {
+  if (align >= KMALLOC_SLAB_SIZE) {
+    log_panic("Unsupported alignment of %lu bytes allocating %lu bytes.", align, size);
+  }
+
+  void* ptr = try_allocate(size, align, caller);
+
+  if (!ptr) {
+    log_panic("Out of kernel heap memory allocating %lu bytes.", size);
+  }
+
+  return ptr;
+}
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size, 0, __builtin_return_address(0)); }
+void* operator new[](size_t size) { return allocate(size, 0, __builtin_return_address(0)); }
+
+void* operator new(size_t size, std::align_val_t align) {
+  return allocate(size, static_cast<size_t>(align), __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+  return allocate(size, static_cast<size_t>(align), __builtin_return_address(0));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return try_allocate(size, 0, __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return try_allocate(size, 0, __builtin_return_address(0));
+}
+
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+  return try_allocate(size, static_cast<size_t>(align), __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+  return try_allocate(size, static_cast<size_t>(align), __builtin_return_address(0));
+}
+
+void operator delete(void* ptr) noexcept { kfree(ptr); }
+void operator delete[](void* ptr) noexcept { kfree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { kfree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { kfree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { kfree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { kfree(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { kfree(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { kfree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { kfree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { kfree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { kfree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { kfree(ptr); }
+
+/**
+ * @brief Called when a pure virtual function is invoked through a partially constructed or
+ * destroyed object.
+ */
+extern "C" void __cxa_pure_virtual();
+
+extern "C" void __cxa_pure_virtual() { log_panic("Pure virtual function called!"); }
\ No newline at end of file
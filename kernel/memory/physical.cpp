@@ -5,72 +5,128 @@
 
 #include <kernel/kernel.h>
 
+#include <kernel/arch/x86_64/cpu/fpu.hpp>
 #include <kernel/memory/memory.hpp>
 #include <kernel/memory/physical.hpp>
-
-uintptr_t PhysicalAllocator::allocate(size_t size) {
+#include <kernel/memory/profiler.hpp>
+#include <kernel/memory/simd.hpp>
+#include <kernel/sync/irq.hpp>
+
+PhysicalAllocator phys_allocator;
+
+/**
+ * @details Searches the bitmap for `page_count` consecutive free pages starting at the last
+ * allocation point, wrapping around to the start of memory once. Candidate runs only start at
+ * indices that satisfy the requested alignment. Large runs are zeroed with non-temporal stores, so
+ * they do not evict the caches.
+ */
+uintptr_t PhysicalAllocator::allocate(size_t size, size_t alignment) {
   if (size == 0) {
     return 0;
   }
 
-  size_t page_count = div_round_up(size, static_cast<size_t>(PAGE_SIZE_4KiB));
+  const size_t page_count = div_round_up(size, static_cast<size_t>(PAGE_SIZE_4KiB));
+  const size_t page_align = std::max(alignment / PAGE_SIZE_4KiB, static_cast<size_t>(1));
 
-  auto allocate_page = [&](size_t upper_limit) -> uintptr_t {
-    size_t idx = 0;
+  auto allocate_page = [&](size_t start, size_t upper_limit) -> uintptr_t {
+    size_t page = align_up(start, page_align);
 
-    while (this->m_last_used_idx > upper_limit) {
-      if (!this->m_bitmap.get(this->m_last_used_idx++)) {
-        if (++idx == page_count) {
-          size_t page = this->m_last_used_idx - page_count;
+    while (page + page_count <= upper_limit) {
+      size_t idx = 0;
 
-          for (size_t i = page; i < page_count; i++) {
-            this->m_bitmap.set(idx);
-          }
+      while (idx < page_count && !this->m_bitmap.get(page + idx)) {
+        idx++;
+      }
 
-          return (page * PAGE_SIZE_4KiB);
+      if (idx == page_count) {
+        for (size_t i = 0; i < page_count; i++) {
+          this->m_bitmap.set(page + i);
         }
-      } else {
-        idx = 0;
+
+        this->m_last_used_idx = page + page_count;
+        return (page * PAGE_SIZE_4KiB);
       }
+
+      page = align_up(page + idx + 1, page_align);
     }
 
     return 0;
   };
 
-  size_t index = this->m_last_used_idx;
-  uintptr_t ret = allocate_page(this->m_highest_usable_addr / PAGE_SIZE_4KiB);
+  const size_t upper_limit = this->m_highest_usable_addr / PAGE_SIZE_4KiB;
+  uintptr_t ret;
 
-  if (!ret) {
-    this->m_last_used_idx = 0;
-    ret = allocate_page(index);
+  {
+    IrqSpinGuard guard(this->m_lock);
+    ret = allocate_page(this->m_last_used_idx, upper_limit);
 
     if (!ret) {
-      log_panic("Out of Physical Memory.");
-      return 0;
+      ret = allocate_page(0, upper_limit);
     }
   }
 
-  memset(reinterpret_cast<void*>(to_higher_half(ret)), 0, page_count * PAGE_SIZE_4KiB);
-  this->m_used_pages += page_count;
+  if (!ret) {
+    log_panic("Out of Physical Memory.");
+    return 0;
+  }
+
+  void* pages = reinterpret_cast<void*>(to_higher_half(ret));
+  const size_t bytes = page_count * PAGE_SIZE_4KiB;
+
+  if (bytes >= ZERO_STREAM_MIN_SIZE && kernel_fpu_usable()) {
+    kernel_fpu_begin();
+    zero_stream_sse2(pages, bytes);
+    kernel_fpu_end();
+  } else {
+    memset(pages, 0, bytes);
+  }
+
+  this->m_used_pages.add(page_count);
 
+  alloc_profile_alloc(ALLOC_SOURCE_PHYSICAL, ret, page_count * PAGE_SIZE_4KiB,
+                      __builtin_return_address(0));
   return ret;
 }
 
-void PhysicalAllocator::free(auto ptr, size_t size) {
-  uintptr_t addr = uintptr_t(ptr);
-
+void PhysicalAllocator::free(uintptr_t addr, size_t size) {
   if (addr == 0) {
     return;
   }
 
-  size_t page_count = div_round_up(size, static_cast<size_t>(PAGE_SIZE_4KiB));
-  size_t page = addr / PAGE_SIZE_4KiB;
+  alloc_profile_free(ALLOC_SOURCE_PHYSICAL, addr);
+
+  const size_t page_count = div_round_up(size, static_cast<size_t>(PAGE_SIZE_4KiB));
+  const size_t page = addr / PAGE_SIZE_4KiB;
+
+  {
+    IrqSpinGuard guard(this->m_lock);
+
+    for (size_t i = 0; i < page_count; i++) {
+      this->m_bitmap.clear(page + i);
+    }
+  }
+
+  this->m_used_pages.add(-static_cast<int64_t>(page_count));
+}
+
+/**
+ * @details The pages were never part of a usable memory map entry during `initialize`, so they are
+ * still marked as used in the bitmap and missing from the page counters.
+ */
+void PhysicalAllocator::adopt(uintptr_t addr, size_t size, size_t used) {
+  IrqSpinGuard guard(this->m_lock);
+
+  const size_t page = addr / PAGE_SIZE_4KiB;
+  const size_t page_count = size / PAGE_SIZE_4KiB;
+  const size_t used_count = div_round_up(used, static_cast<size_t>(PAGE_SIZE_4KiB));
 
-  for (size_t i = 0; i < page_count; i++) {
+  for (size_t i = used_count; i < page_count; i++) {
     this->m_bitmap.clear(page + i);
   }
 
-  this->m_used_pages -= page_count;
+  this->m_total_pages += page_count;
+  this->m_usable_pages += page_count;
+  this->m_used_pages.add(used_count);
 }
 
 void PhysicalAllocator::initialize() {
@@ -85,7 +141,7 @@ void PhysicalAllocator::initialize() {
     switch (memmap->type) {
       case LIMINE_MEMMAP_EXECUTABLE_AND_MODULES:
       case LIMINE_MEMMAP_BOOTLOADER_RECLAIMABLE:
-        this->m_used_pages += memmap->length / PAGE_SIZE_4KiB;
+        this->m_used_pages.add(memmap->length / PAGE_SIZE_4KiB);
         __FALLTHROUGH;
       case LIMINE_MEMMAP_USABLE:
         this->m_usable_pages += memmap->length / PAGE_SIZE_4KiB;
@@ -111,7 +167,7 @@ void PhysicalAllocator::initialize() {
       uintptr_t base = to_higher_half(memmap->base);
       uint8_t* bitmap = reinterpret_cast<uint8_t*>(base);
 
-      memset(bitmap, 0xff, bitmap_entries);
+      memset(bitmap, 0xff, bitmap_size);
       this->m_bitmap.initialize(bitmap, bitmap_entries);
 
       log_debug("Initialized Bitmap at address: %p size: 0x%lx", bitmap, bitmap_entries);
@@ -119,7 +175,7 @@ void PhysicalAllocator::initialize() {
       memmap->base += bitmap_size;
       memmap->length -= bitmap_size;
 
-      this->m_used_pages += bitmap_size / PAGE_SIZE_4KiB;
+      this->m_used_pages.add(bitmap_size / PAGE_SIZE_4KiB);
       break;
     }
   }
@@ -149,7 +205,7 @@ void PhysicalAllocator::initialize() {
 void PhysicalAllocator::info() const {
   log_debug("Total Physical Memory = %lu MB", to_MB(this->m_total_pages * PAGE_SIZE_4KiB));
   log_debug("Usable Physical Memory = %lu MB", to_MB(this->m_usable_pages * PAGE_SIZE_4KiB));
-  log_debug("Used Physical Memory = %lu MB", to_MB(this->m_used_pages * PAGE_SIZE_4KiB));
+  log_debug("Used Physical Memory = %lu MB", to_MB(this->m_used_pages.sum() * PAGE_SIZE_4KiB));
   log_debug("Highest Physical Address = 0x%lx", this->m_highest_phys_addr);
   log_debug("Highest Usable Address = 0x%lx", this->m_highest_usable_addr);
 }
\ No newline at end of file
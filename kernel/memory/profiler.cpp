@@ -0,0 +1,408 @@
+#include <log.hpp>
+
+#include <algorithm>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/memory/profiler.hpp>
+#include <kernel/sync/irq.hpp>
+#include <lock.hpp>
+
+/**
+ * @brief Call sites kept per table at most, leaving a quarter of it free to keep probe sequences
+ * short.
+ */
+#define ALLOC_PROFILER_MAX_SITES (ALLOC_PROFILER_SITES / 4 * 3)
+
+/// @brief Slots of the allocation table guarded by one lock.
+#define ALLOC_PROFILER_SHARD_SIZE (ALLOC_PROFILER_ALLOCATIONS / ALLOC_PROFILER_SHARDS)
+
+/**
+ * @brief Records kept per shard at most, leaving a quarter of it free to keep probe sequences
+ * short.
+ */
+#define ALLOC_PROFILER_MAX_RECORDS (ALLOC_PROFILER_SHARD_SIZE / 4 * 3)
+
+namespace {
+/**
+ * @brief Totals of the allocations and frees of one call site on one processor.
+ *
+ * @details Frees are counted on the processor that frees, so `live_bytes` of a single table can
+ * underflow; only the sum over all processors is meaningful.
+ */
+struct AllocSite {
+  uintptr_t caller;     ///< Return address, 0 if the slot is unused.
+  AllocSource source;   ///< Allocator the call site uses.
+  size_t allocations;   ///< Allocations made so far.
+  size_t frees;         ///< Allocations freed so far.
+  size_t untracked;     ///< Allocations without a record, never counted as live.
+  size_t live_bytes;    ///< Bytes currently allocated in recorded allocations.
+  size_t total_bytes;   ///< Bytes allocated so far.
+  uint64_t first_seen;  ///< Timestamp of the first allocation, 0 before it.
+};
+
+/**
+ * @brief Call sites seen by one processor, only written by that processor.
+ */
+struct alignas(CACHE_LINE_SIZE) SiteTable {
+  AllocSite sites[ALLOC_PROFILER_SITES];
+  size_t count;          ///< Number of used slots in `sites`.
+  size_t dropped;        ///< Allocations not recorded because a table was full.
+  size_t dropped_bytes;  ///< Bytes of the allocations in `dropped`.
+  size_t lost_frees;     ///< Frees of recorded allocations that no site could be charged with.
+};
+
+/**
+ * @brief A single live allocation.
+ */
+struct AllocRecord {
+  uintptr_t address;   ///< Address tagged with the source, see `record_key`, 0 if unused.
+  uintptr_t caller;    ///< Return address of the call site.
+  uint64_t timestamp;  ///< Timestamp of the allocation.
+  uint32_t size;       ///< Size in bytes, saturated at 4 GiB.
+};
+
+/**
+ * @brief Part of the allocation table with a lock of its own, so that allocations on different
+ * processors rarely contend.
+ */
+struct alignas(CACHE_LINE_SIZE) RecordShard {
+  TicketLock lock;
+  size_t count;  ///< Number of used slots in `records`.
+  AllocRecord records[ALLOC_PROFILER_SHARD_SIZE];
+};
+
+SiteTable tables[MAX_CPUS];
+RecordShard shards[ALLOC_PROFILER_SHARDS];
+
+AllocSite merged[ALLOC_PROFILER_SITES];  ///< Scratch space of `alloc_profiler_dump`.
+uint64_t oldest[ALLOC_PROFILER_SITES];   ///< Scratch space of `alloc_profiler_dump`.
+TicketLock dump_lock;                    ///< Serializes users of the scratch space.
+
+/**
+ * @details Allocations are at least 8 byte aligned, so bit 0 is free to keep heap and physical
+ * addresses apart in the same table.
+ */
+uintptr_t record_key(AllocSource source, uintptr_t address) { return address | source; }
+
+size_t hash(uintptr_t value) { return (value * 0x9e3779b97f4a7c15ull) >> 32; }
+
+/// @brief Returns the shard holding the record of `key`.
+RecordShard& shard_of(uintptr_t key) { return shards[hash(key) % ALLOC_PROFILER_SHARDS]; }
+
+/// @brief Returns the first slot of the probe sequence of `key` within its shard.
+size_t record_home(uintptr_t key) {
+  return (hash(key) / ALLOC_PROFILER_SHARDS) & (ALLOC_PROFILER_SHARD_SIZE - 1);
+}
+
+/**
+ * @brief Finds the slot of a call site in `sites`, claiming a free one if `count` allows.
+ */
+AllocSite* find_site(AllocSite* sites, size_t& count, AllocSource source, uintptr_t caller) {
+  const size_t mask = ALLOC_PROFILER_SITES - 1;
+
+  for (size_t idx = hash(caller) & mask;; idx = (idx + 1) & mask) {
+    AllocSite& site = sites[idx];
+
+    if (site.caller == caller && site.source == source) {
+      return &site;
+    }
+
+    if (site.caller == 0) {
+      if (count == ALLOC_PROFILER_MAX_SITES) {
+        return nullptr;
+      }
+
+      site = {caller, source, 0, 0, 0, 0, 0, 0};
+      count++;
+      return &site;
+    }
+  }
+}
+
+/**
+ * @brief Stores `record` in its shard.
+ * @return `false` if the shard is full.
+ */
+bool insert_record(const AllocRecord& record) {
+  RecordShard& shard = shard_of(record.address);
+  IrqSpinGuard guard(shard.lock);
+
+  if (shard.count == ALLOC_PROFILER_MAX_RECORDS) {
+    return false;
+  }
+
+  const size_t mask = ALLOC_PROFILER_SHARD_SIZE - 1;
+  size_t idx = record_home(record.address);
+
+  while (shard.records[idx].address) {
+    idx = (idx + 1) & mask;
+  }
+
+  shard.records[idx] = record;
+  shard.count++;
+  return true;
+}
+
+/**
+ * @brief Removes the record of `key` from its shard and copies it to `record`.
+ * @return `false` if the allocation has no record.
+ *
+ * @details Entries later in the same probe sequence move back into the hole, so lookups never
+ * need tombstones.
+ */
+bool erase_record(uintptr_t key, AllocRecord& record) {
+  RecordShard& shard = shard_of(key);
+  IrqSpinGuard guard(shard.lock);
+
+  const size_t mask = ALLOC_PROFILER_SHARD_SIZE - 1;
+  size_t hole = record_home(key);
+
+  while (shard.records[hole].address != key) {
+    if (!shard.records[hole].address) {
+      return false;
+    }
+
+    hole = (hole + 1) & mask;
+  }
+
+  record = shard.records[hole];
+
+  for (size_t idx = (hole + 1) & mask; shard.records[idx].address; idx = (idx + 1) & mask) {
+    const size_t home = record_home(shard.records[idx].address);
+
+    if (((idx - home) & mask) >= ((idx - hole) & mask)) {
+      shard.records[hole] = shard.records[idx];
+      hole = idx;
+    }
+  }
+
+  shard.records[hole].address = 0;
+  shard.count--;
+  return true;
+}
+
+/**
+ * @details Sums up the counters of every call site over all processors into `merged`. Other
+ * processors keep recording meanwhile, so the result is a slightly inconsistent snapshot. The
+ * allocations missing from the result, their bytes and the lost frees are added to the arguments.
+ */
+void merge_tables(size_t& dropped, size_t& dropped_bytes, size_t& lost_frees) {
+  size_t count = 0;
+
+  for (auto& site : merged) {
+    site = {};
+  }
+
+  for (uint32_t cpu = 0; cpu < cpu_count(); cpu++) {
+    const SiteTable& table = tables[cpu];
+    dropped += table.dropped;
+    dropped_bytes += table.dropped_bytes;
+    lost_frees += table.lost_frees;
+
+    for (const auto& site : table.sites) {
+      if (!site.caller) {
+        continue;
+      }
+
+      AllocSite* total = find_site(merged, count, site.source, site.caller);
+
+      if (!total) {
+        dropped += site.allocations;
+        dropped_bytes += site.total_bytes;
+        continue;
+      }
+
+      total->allocations += site.allocations;
+      total->frees += site.frees;
+      total->untracked += site.untracked;
+      total->live_bytes += site.live_bytes;
+      total->total_bytes += site.total_bytes;
+
+      if (site.first_seen && (!total->first_seen || site.first_seen < total->first_seen)) {
+        total->first_seen = site.first_seen;
+      }
+    }
+  }
+}
+
+/**
+ * @details Finds the oldest live allocation of every merged call site, one shard at a time. A
+ * `count` at the limit keeps `find_site` from claiming slots for unknown sites.
+ */
+void find_oldest() {
+  size_t count = ALLOC_PROFILER_MAX_SITES;
+
+  for (auto& timestamp : oldest) {
+    timestamp = 0;
+  }
+
+  for (auto& shard : shards) {
+    IrqSpinGuard guard(shard.lock);
+
+    for (const auto& record : shard.records) {
+      if (!record.address) {
+        continue;
+      }
+
+      const AllocSource source = static_cast<AllocSource>(record.address & 1);
+      const AllocSite* site = find_site(merged, count, source, record.caller);
+
+      if (site) {
+        uint64_t& timestamp = oldest[site - merged];
+        timestamp = timestamp ? std::min(timestamp, record.timestamp) : record.timestamp;
+      }
+    }
+  }
+}
+
+void print_site(size_t idx, uint64_t now) {
+  const AllocSite& site = merged[idx];
+  const uint64_t elapsed = std::max(now - site.first_seen, static_cast<uint64_t>(1));
+  const uint64_t rate = site.first_seen ? (site.allocations * 1000000ull) / elapsed : 0;
+  const uint64_t age = oldest[idx] ? (now - oldest[idx]) / 1000000 : 0;
+
+  log_info("  %p %s live: %lu B in %lu allocs (oldest %lu Mcycles) total: %lu B in %lu allocs "
+           "rate: %lu/Mcycle",
+           reinterpret_cast<void*>(site.caller), site.source == ALLOC_SOURCE_HEAP ? "heap" : "phys",
+           site.live_bytes, site.allocations - site.frees - site.untracked, age, site.total_bytes,
+           site.allocations, rate);
+}
+
+/**
+ * @details Selects the `top` best sites with a partial selection sort over an index array, so the
+ * dump works without allocating.
+ */
+template <typename Compare>
+void print_ranking(const char* title, size_t top, uint64_t now, Compare better) {
+  static uint16_t order[ALLOC_PROFILER_SITES];
+  size_t count = 0;
+
+  for (size_t i = 0; i < ALLOC_PROFILER_SITES; i++) {
+    if (merged[i].caller) {
+      order[count++] = static_cast<uint16_t>(i);
+    }
+  }
+
+  top = std::min(top, count);
+  log_info("Top %lu call sites by %s:", top, title);
+
+  for (size_t i = 0; i < top; i++) {
+    for (size_t j = i + 1; j < count; j++) {
+      if (better(merged[order[j]], merged[order[i]])) {
+        std::swap(order[i], order[j]);
+      }
+    }
+
+    print_site(order[i], now);
+  }
+}
+}  // namespace
+
+/**
+ * @details The call site is counted in the table of the executing processor with interrupts
+ * disabled, only the record of the allocation goes to a shared shard.
+ */
+void alloc_profiler_record(AllocSource source, uintptr_t address, size_t size, uintptr_t caller) {
+  if (!address) {
+    return;
+  }
+
+  const uint64_t now = rdtsc();
+  const uint64_t flags = arch_interrupt_save();
+  SiteTable& table = tables[arch_cpu_index()];
+  AllocSite* site = find_site(table.sites, table.count, source, caller);
+
+  if (site) {
+    const size_t saturated = std::min(size, static_cast<size_t>(UINT32_MAX));
+
+    site->allocations++;
+    site->total_bytes += size;
+    site->first_seen = site->first_seen ? site->first_seen : now;
+
+    if (insert_record({record_key(source, address), caller, now,
+                       static_cast<uint32_t>(saturated)})) {
+      site->live_bytes += saturated;
+      arch_interrupt_restore(flags);
+      return;
+    }
+
+    site->untracked++;
+  }
+
+  table.dropped++;
+  table.dropped_bytes += size;
+  arch_interrupt_restore(flags);
+}
+
+/**
+ * @details The free is charged to the call site in the table of the executing processor, which
+ * need not be the one that counted the allocation.
+ */
+void alloc_profiler_forget(AllocSource source, uintptr_t address) {
+  if (!address) {
+    return;
+  }
+
+  AllocRecord record;
+
+  if (!erase_record(record_key(source, address), record)) {
+    return;
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+  SiteTable& table = tables[arch_cpu_index()];
+  AllocSite* site = find_site(table.sites, table.count, source, record.caller);
+
+  if (site) {
+    site->frees++;
+    site->live_bytes -= record.size;
+  } else {
+    table.lost_frees++;
+  }
+
+  arch_interrupt_restore(flags);
+}
+
+/**
+ * @details The allocation rate of a site is its number of allocations divided by the time since
+ * its first allocation, in allocations per million timestamp counter cycles. Each site also shows
+ * the age of its oldest live allocation, which helps to tell leaks from long-lived caches.
+ */
+void alloc_profiler_dump(size_t top) {
+  LockGuard guard(dump_lock);
+
+  size_t dropped = 0;
+  size_t dropped_bytes = 0;
+  size_t lost_frees = 0;
+
+  merge_tables(dropped, dropped_bytes, lost_frees);
+  find_oldest();
+
+  const uint64_t now = rdtsc();
+
+  print_ranking("live bytes", top, now, [](const AllocSite& a, const AllocSite& b) {
+    return a.live_bytes > b.live_bytes;
+  });
+
+  print_ranking("allocation rate", top, now, [now](const AllocSite& a, const AllocSite& b) {
+    const uint64_t age_a = std::max(now - a.first_seen, static_cast<uint64_t>(1));
+    const uint64_t age_b = std::max(now - b.first_seen, static_cast<uint64_t>(1));
+
+    return static_cast<unsigned __int128>(a.allocations) * age_b >
+           static_cast<unsigned __int128>(b.allocations) * age_a;
+  });
+
+  if (dropped) {
+    log_warn("Allocation profiler dropped %lu allocations of %lu B, the tables are full; they are "
+             "not counted as live.",
+             dropped, dropped_bytes);
+  }
+
+  if (lost_frees) {
+    log_warn("Allocation profiler could not charge %lu frees to their call sites, the live counts "
+             "are too high.",
+             lost_frees);
+  }
+}
\ No newline at end of file
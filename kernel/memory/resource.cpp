@@ -0,0 +1,66 @@
+#include <algorithm>
+
+#include <kernel/memory/memory.hpp>
+#include <kernel/memory/resource.hpp>
+#include <kernel/memory/slab.hpp>
+
+namespace {
+class HeapResource final : public MemoryResource {
+ public:
+  constexpr HeapResource() = default;
+
+ protected:
+  void* do_allocate(size_t bytes, size_t align) override { return kmalloc_aligned(bytes, align); }
+  void do_deallocate(void* ptr, size_t, size_t) override { kfree(ptr); }
+};
+
+HeapResource heap;
+}  // namespace
+
+MemoryResource* heap_resource() { return &heap; }
+
+/**
+ * @details Allocations that do not fit into the rest of the current chunk start a new chunk, the
+ * space left behind in the old one is not reused.
+ */
+void* ArenaResource::do_allocate(size_t bytes, size_t align) {
+  uintptr_t start = align_up(this->m_cursor, align);
+
+  if (!this->m_chunks || start + bytes > this->m_end || start < this->m_cursor) {
+    const size_t needed = sizeof(Chunk) + align + bytes;
+    const size_t size = std::max(this->m_next_chunk_size, needed);
+
+    auto* chunk = static_cast<Chunk*>(this->m_upstream->allocate(size, alignof(Chunk)));
+
+    if (!chunk) {
+      return nullptr;
+    }
+
+    chunk->next = this->m_chunks;
+    chunk->size = size;
+
+    this->m_chunks = chunk;
+    this->m_cursor = reinterpret_cast<uintptr_t>(chunk) + sizeof(Chunk);
+    this->m_end = reinterpret_cast<uintptr_t>(chunk) + size;
+    this->m_next_chunk_size =
+        std::min(this->m_next_chunk_size * 2, static_cast<size_t>(ARENA_MAX_CHUNK_SIZE));
+
+    start = align_up(this->m_cursor, align);
+  }
+
+  this->m_cursor = start + bytes;
+  this->m_allocated += bytes;
+
+  return reinterpret_cast<void*>(start);
+}
+
+void ArenaResource::release() {
+  while (Chunk* chunk = this->m_chunks) {
+    this->m_chunks = chunk->next;
+    this->m_upstream->deallocate(chunk, chunk->size, alignof(Chunk));
+  }
+
+  this->m_cursor = 0;
+  this->m_end = 0;
+  this->m_allocated = 0;
+}
\ No newline at end of file
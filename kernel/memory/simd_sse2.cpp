@@ -0,0 +1,27 @@
+#include <kernel/memory/simd.hpp>
+
+namespace {
+using Vector = long long __attribute__((vector_size(16)));
+}  // namespace
+
+/**
+ * @details Writes a cache line per iteration. The stores are weakly ordered, the closing fence
+ * orders them before anything the caller does next.
+ */
+void zero_stream_sse2(void* addr, size_t size) {
+  const Vector zero = {};
+  Vector* line = static_cast<Vector*>(addr);
+  Vector* end = line + size / sizeof(Vector);
+
+  for (; line < end; line += 4) {
+    asm volatile(
+        "movntdq %4, %0\n"
+        "movntdq %4, %1\n"
+        "movntdq %4, %2\n"
+        "movntdq %4, %3\n"
+        : "=m"(line[0]), "=m"(line[1]), "=m"(line[2]), "=m"(line[3])
+        : "x"(zero));
+  }
+
+  asm volatile("sfence" ::: "memory");
+}
\ No newline at end of file
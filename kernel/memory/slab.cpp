@@ -0,0 +1,633 @@
+#include <assert.h>
+#include <log.hpp>
+
+#include <algorithm>
+#include <new>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/memory/boot.hpp>
+#include <kernel/memory/memory.hpp>
+#include <kernel/memory/physical.hpp>
+#include <kernel/memory/profiler.hpp>
+#include <kernel/memory/slab.hpp>
+#include <kernel/sync/irq.hpp>
+
+#define SLAB_MAGIC 0x51ab51abu
+
+namespace {
+SlabCache cache_cache;
+SlabCache magazine_cache;
+SlabCache kmalloc_caches[KMALLOC_CLASSES];
+
+List<SlabCache> cache_list;
+TicketLock cache_list_lock;
+
+bool heap_ready = false;  ///< Set once the size classes can serve allocations.
+
+constexpr const char* kmalloc_names[KMALLOC_CLASSES] = {
+    "kmalloc-8",   "kmalloc-16",  "kmalloc-32",   "kmalloc-64",   "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", "kmalloc-2048", "kmalloc-4096",
+};
+
+/**
+ * @brief Maps an allocation size to the index of the smallest size class that fits it.
+ */
+size_t kmalloc_index(size_t size) {
+  if (size <= KMALLOC_MIN_SIZE) {
+    return 0;
+  }
+
+  const size_t shift = (sizeof(size_t) * 8) - __builtin_clzl(size - 1);
+  return shift - KMALLOC_MIN_SHIFT;
+}
+
+Slab* slab_of(void* ptr, size_t slab_size) {
+  return reinterpret_cast<Slab*>(align_down(reinterpret_cast<uintptr_t>(ptr), slab_size));
+}
+
+void register_cache(SlabCache* cache) {
+  LockGuard guard(cache_list_lock);
+  cache_list.push_back(cache);
+}
+
+/**
+ * @details Serves allocations above `KMALLOC_MAX_SIZE` directly from the page allocator. The
+ * region still starts with a `Slab` header, with no owning cache, so that `kfree` can tell it
+ * apart from slab objects and knows how many pages to give back.
+ */
+void* kmalloc_large(size_t size, size_t align) {
+  const size_t offset =
+      align_up(sizeof(Slab), std::max(align, static_cast<size_t>(CACHE_LINE_SIZE)));
+  const size_t bytes = align_up(offset + size, static_cast<size_t>(PAGE_SIZE_4KiB));
+
+  const uintptr_t phys = phys_allocator.allocate(bytes, KMALLOC_SLAB_SIZE);
+
+  if (!phys) {
+    return nullptr;
+  }
+
+  Slab* slab = reinterpret_cast<Slab*>(to_higher_half(phys));
+  slab->cache = nullptr;
+  slab->freelist = nullptr;
+  slab->size = bytes;
+  slab->in_use = 1;
+  slab->color = 0;
+  slab->magic = SLAB_MAGIC;
+
+  return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(slab) + offset);
+}
+}  // namespace
+
+/**
+ * @details The free list link lives in the first word of a free object unless the cache has a
+ * constructor. In that case the object must keep its constructed state while it sits on the free
+ * list, so the link is placed in an extra word behind the object instead.
+ *
+ * The slab size is the smallest power-of-two number of pages that holds `SLAB_MIN_OBJECTS`
+ * objects, capped at `SLAB_MAX_SIZE`. Space left over at the end of a slab is used for coloring.
+ */
+bool SlabCache::initialize(const char* name, size_t size, size_t align, kmem_ctor_fn ctor,
+                           kmem_ctor_fn dtor, uint32_t flags, size_t slab_size) {
+  this->m_name = name;
+  this->m_ctor = ctor;
+  this->m_dtor = dtor;
+  this->m_magazines = !(flags & SLAB_NO_MAGAZINES);
+  this->m_object_size = size;
+  this->m_align = std::max(align, sizeof(void*));
+
+  size_t footprint = std::max(size, sizeof(void*));
+
+  if (ctor) {
+    this->m_link_offset = align_up(size, sizeof(void*));
+    footprint = this->m_link_offset + sizeof(void*);
+  }
+
+  this->m_stride = align_up(footprint, this->m_align);
+  this->m_first_offset = align_up(sizeof(Slab), this->m_align);
+
+  if (slab_size == 0) {
+    slab_size = PAGE_SIZE_4KiB;
+
+    while (slab_size < SLAB_MAX_SIZE &&
+           (slab_size - this->m_first_offset) / this->m_stride < SLAB_MIN_OBJECTS) {
+      slab_size *= 2;
+    }
+  }
+
+  this->m_slab_size = slab_size;
+
+  if (this->m_first_offset >= slab_size) {
+    return false;
+  }
+
+  this->m_objects_per_slab = (slab_size - this->m_first_offset) / this->m_stride;
+
+  if (this->m_objects_per_slab == 0) {
+    return false;
+  }
+
+  const size_t leftover =
+      slab_size - this->m_first_offset - (this->m_objects_per_slab * this->m_stride);
+
+  this->m_color_step = std::max(this->m_align, static_cast<size_t>(CACHE_LINE_SIZE));
+  this->m_color_max = align_down(leftover, this->m_color_step);
+  this->m_color_next = 0;
+
+  return true;
+}
+
+void*& SlabCache::next_free(void* object) const {
+  return *reinterpret_cast<void**>(reinterpret_cast<uintptr_t>(object) + this->m_link_offset);
+}
+
+/**
+ * @details Allocates a new slab from the page allocator, constructs every object in it and links
+ * them into the slab's free list. Consecutive slabs cycle through the available color offsets.
+ */
+Slab* SlabCache::grow() {
+  const uintptr_t phys = phys_allocator.allocate(this->m_slab_size, this->m_slab_size);
+
+  if (!phys) {
+    return nullptr;
+  }
+
+  Slab* slab = reinterpret_cast<Slab*>(to_higher_half(phys));
+  slab->cache = this;
+  slab->freelist = nullptr;
+  slab->size = this->m_slab_size;
+  slab->in_use = 0;
+  slab->color = static_cast<uint32_t>(this->m_color_next);
+  slab->magic = SLAB_MAGIC;
+
+  this->m_color_next += this->m_color_step;
+
+  if (this->m_color_next > this->m_color_max) {
+    this->m_color_next = 0;
+  }
+
+  const uintptr_t first = reinterpret_cast<uintptr_t>(slab) + this->m_first_offset + slab->color;
+
+  for (size_t i = this->m_objects_per_slab; i > 0; i--) {
+    void* object = reinterpret_cast<void*>(first + ((i - 1) * this->m_stride));
+
+    if (this->m_ctor) {
+      this->m_ctor(object);
+    }
+
+    this->next_free(object) = slab->freelist;
+    slab->freelist = object;
+  }
+
+  this->m_total_slabs++;
+  return slab;
+}
+
+/**
+ * @details Runs the destructor over every object of an empty slab and hands its pages back to
+ * the page allocator.
+ */
+void SlabCache::release(Slab* slab) {
+  if (this->m_dtor) {
+    const uintptr_t first = reinterpret_cast<uintptr_t>(slab) + this->m_first_offset + slab->color;
+
+    for (size_t i = 0; i < this->m_objects_per_slab; i++) {
+      this->m_dtor(reinterpret_cast<void*>(first + (i * this->m_stride)));
+    }
+  }
+
+  slab->magic = 0;
+  this->m_total_slabs--;
+
+  phys_allocator.free(from_higher_half(reinterpret_cast<uintptr_t>(slab)), this->m_slab_size);
+}
+
+/**
+ * @details Prefers partially used slabs so that empty ones can be reclaimed, then falls back to a
+ * cached empty slab and finally grows the cache by one slab.
+ */
+void* SlabCache::slab_allocate() {
+  IrqSpinGuard guard(this->m_lock);
+
+  Slab* slab = this->m_partial.front();
+
+  if (!slab) {
+    slab = this->m_empty.pop_front();
+
+    if (!slab) {
+      slab = this->grow();
+
+      if (!slab) {
+        return nullptr;
+      }
+    }
+
+    this->m_partial.push_front(slab);
+  }
+
+  void* object = slab->freelist;
+  slab->freelist = this->next_free(object);
+  slab->in_use++;
+
+  if (slab->in_use == this->m_objects_per_slab) {
+    this->m_partial.remove(slab);
+    this->m_full.push_front(slab);
+  }
+
+  this->m_active_objects++;
+  return object;
+}
+
+/**
+ * @details Slabs are aligned to their size, so the header of the slab owning `object` is found by
+ * rounding the pointer down. A slab that becomes empty is kept as a reserve or reclaimed right
+ * away once the reserve is full.
+ */
+void SlabCache::slab_free(void* object) {
+  Slab* slab = slab_of(object, this->m_slab_size);
+
+  assert(slab->magic == SLAB_MAGIC && slab->cache == this);
+
+  IrqSpinGuard guard(this->m_lock);
+
+  if (slab->in_use == this->m_objects_per_slab) {
+    this->m_full.remove(slab);
+    this->m_partial.push_front(slab);
+  }
+
+  this->next_free(object) = slab->freelist;
+  slab->freelist = object;
+  slab->in_use--;
+  this->m_active_objects--;
+
+  if (slab->in_use == 0) {
+    this->m_partial.remove(slab);
+
+    if (this->m_empty.size() < SLAB_EMPTY_RESERVE) {
+      this->m_empty.push_front(slab);
+    } else {
+      this->release(slab);
+    }
+  }
+}
+
+/**
+ * @details Called when the loaded magazine is empty. Swaps in the previous magazine if it is full,
+ * otherwise trades the empty previous magazine for a full one from the depot.
+ */
+Magazine* SlabCache::exchange_full(SlabCpuCache& cpu) {
+  if (cpu.previous && cpu.previous->rounds > 0) {
+    std::swap(cpu.loaded, cpu.previous);
+    return cpu.loaded;
+  }
+
+  IrqSpinGuard guard(this->m_depot_lock);
+  Magazine* full = this->m_depot_full.pop_front();
+
+  if (!full) {
+    return nullptr;
+  }
+
+  if (cpu.previous) {
+    this->m_depot_empty.push_front(cpu.previous);
+  }
+
+  cpu.previous = cpu.loaded;
+  cpu.loaded = full;
+
+  return full;
+}
+
+/**
+ * @details Called when the loaded magazine is full or missing. Swaps in the previous magazine if it
+ * is empty, otherwise trades the full previous magazine for an empty one from the depot. Empty
+ * magazines are created on demand, which is how a cache warms up.
+ */
+Magazine* SlabCache::exchange_empty(SlabCpuCache& cpu) {
+  if (cpu.previous && cpu.previous->rounds == 0) {
+    std::swap(cpu.loaded, cpu.previous);
+    return cpu.loaded;
+  }
+
+  IrqSpinGuard guard(this->m_depot_lock);
+  Magazine* empty = this->m_depot_empty.pop_front();
+
+  if (!empty) {
+    void* memory = magazine_cache.allocate();
+
+    if (!memory) {
+      return nullptr;
+    }
+
+    empty = new (memory) Magazine();
+  }
+
+  if (cpu.previous) {
+    this->m_depot_full.push_front(cpu.previous);
+  }
+
+  cpu.previous = cpu.loaded;
+  cpu.loaded = empty;
+
+  return empty;
+}
+
+/**
+ * @details The fast path pops an object from the loaded magazine of the executing CPU. Interrupts
+ * are disabled so that nothing else can run on this CPU in between, which makes locks and atomics
+ * unnecessary. Only if no magazine holds an object does the allocation fall through to the slabs.
+ */
+void* SlabCache::allocate() {
+  if (!this->m_magazines) {
+    return this->slab_allocate();
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+  SlabCpuCache& cpu = this->m_cpu[arch_cpu_index()];
+  void* object = nullptr;
+
+  Magazine* magazine = cpu.loaded;
+
+  if (!magazine || magazine->rounds == 0) {
+    magazine = this->exchange_full(cpu);
+  }
+
+  if (magazine) {
+    object = magazine->objects[--magazine->rounds];
+  }
+
+  arch_interrupt_restore(flags);
+
+  return object ? object : this->slab_allocate();
+}
+
+/**
+ * @details The fast path pushes the object onto the loaded magazine of the executing CPU. If no
+ * empty magazine can be found or created, the object goes straight back to its slab.
+ */
+void SlabCache::free(void* object) {
+  if (!this->m_magazines) {
+    this->slab_free(object);
+    return;
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+  SlabCpuCache& cpu = this->m_cpu[arch_cpu_index()];
+
+  Magazine* magazine = cpu.loaded;
+
+  if (!magazine || magazine->rounds == MAGAZINE_ROUNDS) {
+    magazine = this->exchange_empty(cpu);
+  }
+
+  if (magazine) {
+    magazine->objects[magazine->rounds++] = object;
+  }
+
+  arch_interrupt_restore(flags);
+
+  if (!magazine) {
+    this->slab_free(object);
+  }
+}
+
+/**
+ * @details Hands every round of the magazine back to its slab and frees the magazine itself.
+ */
+void SlabCache::drain_magazine(Magazine* magazine) {
+  while (magazine->rounds > 0) {
+    this->slab_free(magazine->objects[--magazine->rounds]);
+  }
+
+  magazine_cache.free(magazine);
+}
+
+void SlabCache::drain_cpu(SlabCpuCache& cpu) {
+  const uint64_t flags = arch_interrupt_save();
+  Magazine* loaded = cpu.loaded;
+  Magazine* previous = cpu.previous;
+
+  cpu.loaded = nullptr;
+  cpu.previous = nullptr;
+  arch_interrupt_restore(flags);
+
+  if (loaded) {
+    this->drain_magazine(loaded);
+  }
+
+  if (previous) {
+    this->drain_magazine(previous);
+  }
+}
+
+void SlabCache::drain_depot() {
+  List<Magazine> full;
+  List<Magazine> empty;
+
+  {
+    IrqSpinGuard guard(this->m_depot_lock);
+    std::swap(full, this->m_depot_full);
+    std::swap(empty, this->m_depot_empty);
+  }
+
+  while (Magazine* magazine = full.pop_front()) {
+    this->drain_magazine(magazine);
+  }
+
+  while (Magazine* magazine = empty.pop_front()) {
+    this->drain_magazine(magazine);
+  }
+}
+
+void SlabCache::drain_all() {
+  if (!this->m_magazines) {
+    return;
+  }
+
+  for (size_t i = 0; i < MAX_CPUS; i++) {
+    this->drain_cpu(this->m_cpu[i]);
+  }
+
+  this->drain_depot();
+}
+
+size_t SlabCache::shrink() {
+  if (this->m_magazines) {
+    this->drain_cpu(this->m_cpu[arch_cpu_index()]);
+    this->drain_depot();
+  }
+
+  IrqSpinGuard guard(this->m_lock);
+  size_t released = 0;
+
+  while (Slab* slab = this->m_empty.pop_front()) {
+    this->release(slab);
+    released += this->m_slab_size;
+  }
+
+  return released;
+}
+
+void SlabCache::info() const {
+  log_debug("%-14s obj: %5lu B slab: %3lu KB objs/slab: %4lu slabs: %4lu active: %6lu",
+            this->m_name, this->m_object_size, to_KB(this->m_slab_size), this->m_objects_per_slab,
+            this->m_total_slabs, this->m_active_objects);
+}
+
+SlabCache* kmem_cache_create(const char* name, size_t size, size_t align, kmem_ctor_fn ctor,
+                             kmem_ctor_fn dtor) {
+  void* memory = cache_cache.allocate();
+
+  if (!memory) {
+    return nullptr;
+  }
+
+  SlabCache* cache = new (memory) SlabCache();
+
+  if (!cache->initialize(name, size, align, ctor, dtor)) {
+    log_error("Object cache '%s' cannot hold objects of %lu bytes.", name, size);
+    cache_cache.free(cache);
+    return nullptr;
+  }
+
+  register_cache(cache);
+  return cache;
+}
+
+void kmem_cache_destroy(SlabCache* cache) {
+  cache->drain_all();
+
+  if (cache->active_objects() != 0) {
+    log_error("Destroying object cache '%s' with %lu objects still in use.", cache->name(),
+              cache->active_objects());
+    return;
+  }
+
+  {
+    LockGuard guard(cache_list_lock);
+    cache_list.remove(cache);
+  }
+
+  cache->shrink();
+  cache->~SlabCache();
+  cache_cache.free(cache);
+}
+
+void* kmem_cache_alloc(SlabCache* cache) {
+  void* object = cache->allocate();
+  alloc_profile_alloc(ALLOC_SOURCE_HEAP, object, cache->object_size(), __builtin_return_address(0));
+  return object;
+}
+
+void kmem_cache_free(SlabCache* cache, void* object) {
+  alloc_profile_free(ALLOC_SOURCE_HEAP, object);
+  cache->free(object);
+}
+
+size_t kmem_cache_shrink(SlabCache* cache) { return cache->shrink(); }
+
+size_t kmem_reap() {
+  LockGuard guard(cache_list_lock);
+  size_t released = 0;
+
+  for (SlabCache* cache = cache_list.front(); cache; cache = cache_list.next(cache)) {
+    released += cache->shrink();
+  }
+
+  return released;
+}
+
+/**
+ * @details Size classes are naturally aligned, so any alignment up to the size class comes for
+ * free. Large allocations place the object at an aligned offset behind their header, which has to
+ * stay below `KMALLOC_SLAB_SIZE` for `kfree` to find the header again. Until `kmem_initialize` has
+ * run, allocations are served by the boot arena.
+ */
+void* kmalloc_caller(size_t size, size_t align, [[maybe_unused]] void* caller) {
+  if (size == 0 || (align & (align - 1)) != 0 || align >= KMALLOC_SLAB_SIZE) {
+    return nullptr;
+  }
+
+  void* ptr = nullptr;
+  const size_t fitted = std::max(size, align);
+
+  if (!heap_ready) [[unlikely]] {
+    ptr = boot_alloc(size, std::max(align, static_cast<size_t>(BOOT_ARENA_DEFAULT_ALIGN)));
+  } else if (fitted > KMALLOC_MAX_SIZE) {
+    ptr = kmalloc_large(size, align);
+  } else {
+    ptr = kmalloc_caches[kmalloc_index(fitted)].allocate();
+  }
+
+  alloc_profile_alloc(ALLOC_SOURCE_HEAP, ptr, size, caller);
+  return ptr;
+}
+
+void* kmalloc(size_t size) { return kmalloc_caller(size, 1, __builtin_return_address(0)); }
+
+void* kmalloc_aligned(size_t size, size_t align) {
+  return kmalloc_caller(size, align, __builtin_return_address(0));
+}
+
+/**
+ * @details Every kmalloc allocation lives within `KMALLOC_SLAB_SIZE` bytes of a `Slab` header
+ * aligned to that size. Headers without an owning cache describe large allocations. Memory handed
+ * out by the boot arena before the heap was up is never freed.
+ */
+void kfree(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  alloc_profile_free(ALLOC_SOURCE_HEAP, ptr);
+
+  if (boot_arena_owns(ptr)) {
+    return;
+  }
+
+  Slab* slab = slab_of(ptr, KMALLOC_SLAB_SIZE);
+
+  assert(slab->magic == SLAB_MAGIC);
+
+  if (!slab->cache) {
+    slab->magic = 0;
+    phys_allocator.free(from_higher_half(reinterpret_cast<uintptr_t>(slab)), slab->size);
+    return;
+  }
+
+  slab->cache->free(ptr);
+}
+
+/**
+ * @details Sets up the caches that hold `SlabCache` and `Magazine` objects themselves, followed by
+ * one cache per power-of-two size class. Size classes are naturally aligned. The two internal
+ * caches bypass the magazine layer, since magazines are allocated from inside it.
+ */
+void kmem_initialize() {
+  cache_cache.initialize("slab_cache", sizeof(SlabCache), alignof(SlabCache), nullptr, nullptr,
+                         SLAB_NO_MAGAZINES);
+  register_cache(&cache_cache);
+
+  magazine_cache.initialize("magazine", sizeof(Magazine), alignof(Magazine), nullptr, nullptr,
+                            SLAB_NO_MAGAZINES);
+  register_cache(&magazine_cache);
+
+  for (size_t i = 0; i < KMALLOC_CLASSES; i++) {
+    const size_t size = KMALLOC_MIN_SIZE << i;
+
+    kmalloc_caches[i].initialize(kmalloc_names[i], size, size, nullptr, nullptr, 0,
+                                 KMALLOC_SLAB_SIZE);
+    register_cache(&kmalloc_caches[i]);
+  }
+
+  heap_ready = true;
+
+  log_info("Initialized kernel heap with %d size classes!", KMALLOC_CLASSES);
+}
+
+void kmem_info() {
+  LockGuard guard(cache_list_lock);
+
+  for (SlabCache* cache = cache_list.front(); cache; cache = cache_list.next(cache)) {
+    cache->info();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,474 @@
+#include <log.hpp>
+
+#include <atomic>
+#include <new>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/context.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/idle.hpp>
+#include <kernel/arch/x86_64/cpu/paging.hpp>
+#include <kernel/memory/memory.hpp>
+#include <kernel/memory/physical.hpp>
+#include <kernel/memory/slab.hpp>
+#include <kernel/sched/thread.hpp>
+#include <kernel/sync/irq.hpp>
+#include <kernel/sync/rcu.hpp>
+#include <kernel/time/clock.hpp>
+#include <lock.hpp>
+
+namespace {
+/**
+ * @brief Threads of one processor, ready threads may be added from any processor.
+ */
+struct alignas(CACHE_LINE_SIZE) RunQueue {
+  TicketLock lock;
+  Thread* head = nullptr;
+  Thread* tail = nullptr;
+
+  Thread* current = nullptr;   ///< Thread running on the processor.
+  Thread* previous = nullptr;  ///< Thread the last switch left, reaped if it exited.
+  uint64_t switched_at = 0;    ///< TSC value of the last switch.
+
+  Thread idle;  ///< Context that initialized the processor.
+};
+
+RunQueue run_queues[MAX_CPUS];
+
+/**
+ * @details Slots are mapped once and never unmapped, freed slots are reused first.
+ */
+TicketLock stack_lock;
+uint32_t free_stacks[THREAD_MAX_STACKS];
+uint32_t free_stack_count = 0;
+uint32_t mapped_stack_count = 0;
+
+/// @brief Returns the lowest address of the stack in `slot`, the guard page lies below it.
+uintptr_t stack_bottom(uint32_t slot) {
+  return THREAD_STACK_REGION + slot * (THREAD_GUARD_SIZE + THREAD_STACK_SIZE) + THREAD_GUARD_SIZE;
+}
+
+/**
+ * @details A new slot is reserved under the lock and mapped outside of it. The stack pages are
+ * contiguous in physical memory but mapped with 4 KiB pages, the guard page must stay unmapped.
+ */
+bool stack_allocate(uint32_t& slot) {
+  {
+    LockGuard guard(stack_lock);
+
+    if (free_stack_count) {
+      slot = free_stacks[--free_stack_count];
+      return true;
+    }
+
+    if (mapped_stack_count == THREAD_MAX_STACKS) {
+      return false;
+    }
+
+    slot = mapped_stack_count++;
+  }
+
+  const uintptr_t phys = phys_allocator.allocate(THREAD_STACK_SIZE);
+  const uintptr_t bottom = stack_bottom(slot);
+
+  for (size_t offset = 0; offset < THREAD_STACK_SIZE; offset += PAGE_SIZE_4KiB) {
+    if (!map_kernel_page(bottom + offset, phys + offset, PTE_WRITABLE | PTE_NO_EXECUTE)) {
+      log_panic("Kernel stack at %#lx is already mapped.", bottom + offset);
+    }
+  }
+
+  return true;
+}
+
+void stack_free(uint32_t slot) {
+  LockGuard guard(stack_lock);
+  free_stacks[free_stack_count++] = slot;
+}
+
+void enqueue(RunQueue& queue, Thread* thread) {
+  thread->next = nullptr;
+
+  if (queue.tail) {
+    queue.tail->next = thread;
+  } else {
+    queue.head = thread;
+  }
+
+  queue.tail = thread;
+}
+
+/**
+ * @brief Removes the first ready thread, or returns the idle thread if none is ready.
+ * @details Called with the queue locked, marks the returned thread running.
+ */
+Thread* pick_next(RunQueue& queue) {
+  Thread* next = queue.head;
+
+  if (next) {
+    queue.head = next->next;
+
+    if (!queue.head) {
+      queue.tail = nullptr;
+    }
+  } else {
+    next = &queue.idle;
+  }
+
+  next->state = THREAD_RUNNING;
+  return next;
+}
+
+/**
+ * @brief Completes a switch on the thread switched to.
+ * @return The thread the switch left if it exited, to be reaped with interrupts enabled.
+ */
+Thread* finish_switch(RunQueue& queue) {
+  Thread* previous = queue.previous;
+  queue.previous = nullptr;
+
+  return previous && previous->state == THREAD_DEAD ? previous : nullptr;
+}
+
+/**
+ * @brief Switches from the running thread to `next`, returns once the running thread runs again.
+ *
+ * @details Called with interrupts disabled and the queue unlocked. Only the processor of a queue
+ * takes threads from it, and it cannot do so before the switch completed, so a thread made ready
+ * by another processor while it is switched away is not resumed on its old stack pointer.
+ * @return See `finish_switch`.
+ */
+Thread* switch_to(RunQueue& queue, Thread* next) {
+  Thread* previous = queue.current;
+  const uint64_t now = now_cycles();
+
+  previous->run_cycles += now - queue.switched_at;
+  next->switches++;
+
+  queue.switched_at = now;
+  queue.current = next;
+  queue.previous = previous;
+
+  fpu_switch(next->fpu);
+  set_fs_base(reinterpret_cast<uintptr_t>(next));
+  context_switch(&previous->stack_pointer, next->stack_pointer);
+
+  return finish_switch(queue);
+}
+
+void reap(Thread* thread) {
+  if (thread) {
+    if (thread->fpu) {
+      fpu_state_destroy(thread->fpu);
+    }
+
+    stack_free(thread->stack_slot);
+    kfree(thread);
+  }
+}
+
+/**
+ * @details Entered through `context_trampoline` by the first switch to `thread`, with interrupts
+ * still disabled by it.
+ */
+__NO_RETURN void thread_entry(Thread* thread) {
+  Thread* dead = finish_switch(run_queues[thread->cpu]);
+
+  arch_enable_interrupts();
+  reap(dead);
+
+  thread->function(thread->arg);
+  thread_exit();
+}
+}  // namespace
+
+void thread_cpu_initialize() {
+  const uint32_t cpu = arch_cpu_index();
+  RunQueue& queue = run_queues[cpu];
+  Thread* idle = &queue.idle;
+
+  idle->self = idle;
+  idle->cpu = cpu;
+  idle->state = THREAD_RUNNING;
+  idle->name = "idle";
+
+  queue.current = idle;
+  queue.switched_at = now_cycles();
+
+  set_fs_base(reinterpret_cast<uintptr_t>(idle));
+}
+
+/**
+ * @details The stack starts with a `ContextFrame` that returns into `context_trampoline`, which
+ * calls `thread_entry` with the stack aligned like after any other call.
+ */
+Thread* thread_create(ThreadFunction function, void* arg, const char* name) {
+  uint32_t slot;
+
+  if (!stack_allocate(slot)) {
+    log_error("No kernel stack left for thread %s.", name);
+    return nullptr;
+  }
+
+  void* memory = kmalloc(sizeof(Thread));
+
+  if (!memory) {
+    stack_free(slot);
+    return nullptr;
+  }
+
+  auto* thread = new (memory) Thread();
+
+  thread->self = thread;
+  thread->function = function;
+  thread->arg = arg;
+  thread->stack_slot = slot;
+  thread->name = name;
+
+  const uintptr_t top = stack_bottom(slot) + THREAD_STACK_SIZE;
+  auto* frame = reinterpret_cast<ContextFrame*>(top - sizeof(ContextFrame));
+
+  *frame = {};
+  frame->r12 = reinterpret_cast<uintptr_t>(thread);
+  frame->r13 = reinterpret_cast<uintptr_t>(thread_entry);
+  frame->rip = reinterpret_cast<uintptr_t>(context_trampoline);
+  thread->stack_pointer = reinterpret_cast<uintptr_t>(frame);
+
+  return thread;
+}
+
+void thread_start(Thread* thread, uint32_t cpu) {
+  RunQueue& queue = run_queues[cpu];
+
+  thread->cpu = cpu;
+
+  {
+    IrqSpinGuard guard(queue.lock);
+    enqueue(queue, thread);
+  }
+
+  idle_wake(cpu);
+}
+
+/**
+ * @details The idle thread is not queued when it yields, it runs again once no thread is ready.
+ */
+void thread_yield() {
+  rcu_quiescent();
+
+  const uint64_t flags = arch_interrupt_save();
+  RunQueue& queue = run_queues[arch_cpu_index()];
+  Thread* current = queue.current;
+
+  queue.lock.lock();
+
+  if (!queue.head) {
+    queue.lock.unlock();
+    arch_interrupt_restore(flags);
+    return;
+  }
+
+  current->state = THREAD_READY;
+
+  if (current != &queue.idle) {
+    enqueue(queue, current);
+  }
+
+  Thread* next = pick_next(queue);
+  queue.lock.unlock();
+
+  Thread* dead = switch_to(queue, next);
+
+  arch_interrupt_restore(flags);
+  reap(dead);
+}
+
+void thread_block() {
+  rcu_quiescent();
+
+  const uint64_t flags = arch_interrupt_save();
+  RunQueue& queue = run_queues[arch_cpu_index()];
+  Thread* current = queue.current;
+
+  if (current == &queue.idle) {
+    log_panic("The idle thread cannot block.");
+  }
+
+  queue.lock.lock();
+
+  if (current->wake_pending) {
+    current->wake_pending = false;
+    queue.lock.unlock();
+    arch_interrupt_restore(flags);
+    return;
+  }
+
+  current->state = THREAD_BLOCKED;
+
+  Thread* next = pick_next(queue);
+  queue.lock.unlock();
+
+  Thread* dead = switch_to(queue, next);
+
+  arch_interrupt_restore(flags);
+  reap(dead);
+}
+
+/**
+ * @details `thread` must not have exited. The wakeup is only recorded for a thread that is not
+ * blocked, the thread is queued on its own processor otherwise.
+ */
+void thread_wake(Thread* thread) {
+  RunQueue& queue = run_queues[thread->cpu];
+
+  {
+    IrqSpinGuard guard(queue.lock);
+
+    if (thread->state != THREAD_BLOCKED) {
+      thread->wake_pending = true;
+      return;
+    }
+
+    thread->state = THREAD_READY;
+    enqueue(queue, thread);
+  }
+
+  idle_wake(thread->cpu);
+}
+
+void thread_exit() {
+  arch_disable_interrupts();
+
+  RunQueue& queue = run_queues[arch_cpu_index()];
+  Thread* current = queue.current;
+
+  if (current == &queue.idle) {
+    log_panic("The idle thread cannot exit.");
+  }
+
+  queue.lock.lock();
+  current->state = THREAD_DEAD;
+
+  Thread* next = pick_next(queue);
+  queue.lock.unlock();
+
+  switch_to(queue, next);
+  __builtin_unreachable();
+}
+
+/**
+ * @details The running thread is found through its run queue, not the FS base, which user mode may
+ * have cleared. Installing the state with `fpu_switch` schedules its load before the next entry to
+ * user mode, and makes kernel FPU sections save the user registers from then on.
+ */
+bool thread_fpu_initialize() {
+  Thread* thread = run_queues[arch_cpu_index()].current;
+
+  if (thread->fpu) {
+    return true;
+  }
+
+  if (!fpu_state_init(&thread->fpu_state)) {
+    return false;
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+  thread->fpu = &thread->fpu_state;
+  fpu_switch(thread->fpu);
+  arch_interrupt_restore(flags);
+
+  return true;
+}
+
+bool thread_ready() {
+  return __atomic_load_n(&run_queues[arch_cpu_index()].head, __ATOMIC_RELAXED) != nullptr;
+}
+
+#ifdef ENABLE_BENCHMARKS
+
+namespace {
+constexpr uint64_t BENCHMARK_WARMUP = 1000;  ///< Round trips made before measuring.
+
+/**
+ * @brief State shared by the two threads of a benchmark run.
+ */
+struct PingPong {
+  Thread* threads[2];              ///< Thread of each side.
+  std::atomic<uint32_t> turn;      ///< Side whose round is next.
+  std::atomic<uint32_t> finished;  ///< Threads that stored their results.
+  uint64_t cycles;                 ///< Duration of the measured round trips.
+  uint64_t switches[2];            ///< Switches to the thread of each side.
+};
+
+PingPong ping_pong;
+
+/**
+ * @details Each round passes the turn to the other side and wakes it. Side 0 measures; its last
+ * round wakes side 1 once more, while the last round of side 1 leaves side 0 alone, which may
+ * already have exited.
+ */
+void ping_pong_side(void* arg) {
+  const auto side = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(arg));
+  constexpr uint64_t rounds = BENCHMARK_WARMUP + THREAD_BENCHMARK_ITERATIONS;
+  Thread* peer = ping_pong.threads[!side];
+  uint64_t start = 0;
+
+  for (uint64_t i = 0; i < rounds; i++) {
+    if (i == BENCHMARK_WARMUP) {
+      start = now_cycles();
+    }
+
+    while (ping_pong.turn.load(std::memory_order_relaxed) != side) {
+      thread_block();
+    }
+
+    ping_pong.turn.store(!side, std::memory_order_relaxed);
+
+    if (side == 0 || i + 1 < rounds) {
+      thread_wake(peer);
+    }
+  }
+
+  if (side == 0) {
+    ping_pong.cycles = now_cycles() - start;
+  }
+
+  ping_pong.switches[side] = this_thread_read(switches);
+  ping_pong.finished.fetch_add(1, std::memory_order_relaxed);
+}
+}  // namespace
+
+/**
+ * @details Both threads run on the executing processor, so every round trip is two switches
+ * between them, including the FS base write and the run time accounting.
+ */
+void thread_benchmark_run() {
+  ping_pong.turn.store(0, std::memory_order_relaxed);
+  ping_pong.finished.store(0, std::memory_order_relaxed);
+
+  for (uintptr_t side = 0; side < 2; side++) {
+    ping_pong.threads[side] =
+        thread_create(ping_pong_side, reinterpret_cast<void*>(side), side ? "pong" : "ping");
+
+    if (!ping_pong.threads[side]) {
+      log_error("Failed to create the thread benchmark.");
+      return;
+    }
+  }
+
+  const uint32_t cpu = arch_cpu_index();
+
+  thread_start(ping_pong.threads[0], cpu);
+  thread_start(ping_pong.threads[1], cpu);
+
+  while (ping_pong.finished.load(std::memory_order_relaxed) < 2) {
+    thread_yield();
+  }
+
+  const uint64_t per_round_trip = ping_pong.cycles / THREAD_BENCHMARK_ITERATIONS;
+
+  log_info("Thread switch round trip, %d iterations: %lu cycles/round trip (%lu ns), %lu switches",
+           THREAD_BENCHMARK_ITERATIONS, per_round_trip, cycles_to_ns(per_round_trip),
+           ping_pong.switches[0] + ping_pong.switches[1]);
+}
+
+#endif  // ENABLE_BENCHMARKS
\ No newline at end of file
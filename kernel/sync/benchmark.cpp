@@ -0,0 +1,157 @@
+#include <log.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/smp.hpp>
+#include <kernel/sync/benchmark.hpp>
+#include <kernel/sync/qspinlock.hpp>
+#include <kernel/sync/rwlock.hpp>
+#include <kernel/sync/seqlock.hpp>
+#include <lock.hpp>
+
+namespace {
+/**
+ * @brief State shared by the processors taking part in one run.
+ */
+template <typename Lock>
+struct Benchmark {
+  Lock lock;
+  uint32_t participants;  ///< Number of processors taking part.
+
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> joined;   ///< Hands out participant slots.
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> arrived;  ///< Start barrier.
+  alignas(CACHE_LINE_SIZE) uint64_t data[2];               ///< Record protected by `lock`.
+
+  uint64_t cycles[MAX_CPUS];  ///< Duration of the run in each participant slot.
+};
+
+/// @brief Critical section measured by a benchmark, returns a value to keep reads alive.
+template <typename Lock>
+using Section = uint64_t (*)(Benchmark<Lock>& bench);
+
+template <typename Lock>
+uint64_t exclusive_write(Benchmark<Lock>& bench) {
+  bench.lock.lock();
+  const uint64_t value = ++bench.data[0];
+  bench.lock.unlock();
+
+  return value;
+}
+
+template <typename Lock>
+uint64_t exclusive_read(Benchmark<Lock>& bench) {
+  bench.lock.lock();
+  const uint64_t value = bench.data[0] + bench.data[1];
+  bench.lock.unlock();
+
+  return value;
+}
+
+template <typename Lock>
+uint64_t shared_read(Benchmark<Lock>& bench) {
+  bench.lock.read_lock();
+  const uint64_t value = bench.data[0] + bench.data[1];
+  bench.lock.read_unlock();
+
+  return value;
+}
+
+uint64_t sequence_read(Benchmark<SeqLock>& bench) {
+  uint64_t value;
+  uint32_t sequence;
+
+  do {
+    sequence = bench.lock.read_begin();
+    value = bench.data[0] + bench.data[1];
+  } while (bench.lock.read_retry(sequence));
+
+  return value;
+}
+
+uint32_t online_cpus() {
+  uint32_t online = 0;
+
+  for (uint32_t i = 0; i < cpu_count(); i++) {
+    if (cpu_data(i)->online.load(std::memory_order_acquire)) {
+      online++;
+    }
+  }
+
+  return online;
+}
+
+/**
+ * @details The first `participants` processors to arrive take part. Each waits until all others
+ * arrived, so the whole run is contended, then runs the section in a loop.
+ */
+template <typename Lock, Section<Lock> Run>
+void contend(void* arg) {
+  auto* bench = static_cast<Benchmark<Lock>*>(arg);
+  const uint32_t slot = bench->joined.fetch_add(1, std::memory_order_relaxed);
+
+  if (slot >= bench->participants) {
+    return;
+  }
+
+  bench->arrived.fetch_add(1, std::memory_order_acq_rel);
+
+  while (bench->arrived.load(std::memory_order_acquire) != bench->participants) {
+    arch_pause();
+  }
+
+  const uint64_t start = rdtsc();
+  uint64_t sum = 0;
+
+  for (size_t i = 0; i < SYNC_BENCHMARK_ITERATIONS; i++) {
+    sum += Run(*bench);
+  }
+
+  bench->cycles[slot] = rdtsc() - start;
+  asm volatile("" ::"r"(sum));
+}
+
+/**
+ * @details Runs on 1, 2, 4, ... and finally all online processors. Write sections increment the
+ * first word of the record, so lost updates reveal a broken lock.
+ */
+template <typename Lock, Section<Lock> Run, bool Writes>
+void run_benchmark(const char* name) {
+  const uint32_t online = online_cpus();
+
+  for (uint32_t cpus = 1;; cpus = std::min(cpus * 2, online)) {
+    Benchmark<Lock> bench = {};
+    bench.participants = cpus;
+
+    smp_call_all(contend<Lock, Run>, &bench);
+
+    const uint64_t cycles = *std::max_element(bench.cycles, bench.cycles + cpus);
+    const uint64_t sections = static_cast<uint64_t>(cpus) * SYNC_BENCHMARK_ITERATIONS;
+
+    if (Writes && bench.data[0] != sections) {
+      log_error("%s lost updates: %lu of %lu", name, bench.data[0], sections);
+    }
+
+    log_info("  %-16s %2u CPUs: %6lu cycles/section", name, cpus, cycles / sections);
+
+    if (cpus == online) {
+      break;
+    }
+  }
+}
+}  // namespace
+
+void sync_benchmark_run() {
+  log_info("Lock contention, %d exclusive sections per CPU:", SYNC_BENCHMARK_ITERATIONS);
+
+  run_benchmark<TicketLock, exclusive_write<TicketLock>, true>("TicketLock");
+  run_benchmark<QueuedSpinLock, exclusive_write<QueuedSpinLock>, true>("QueuedSpinLock");
+
+  log_info("Read-side scaling, %d read sections per CPU:", SYNC_BENCHMARK_ITERATIONS);
+
+  run_benchmark<TicketLock, exclusive_read<TicketLock>, false>("TicketLock");
+  run_benchmark<RwSpinLock, shared_read<RwSpinLock>, false>("RwSpinLock");
+  run_benchmark<PercpuRwLock, shared_read<PercpuRwLock>, false>("PercpuRwLock");
+  run_benchmark<SeqLock, sequence_read, false>("SeqLock");
+}
\ No newline at end of file
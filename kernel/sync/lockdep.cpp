@@ -0,0 +1,155 @@
+#include <log.hpp>
+
+#include <algorithm>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/sync/lockdep.hpp>
+#include <lock.hpp>
+
+namespace {
+struct HeldLock {
+  const void* lock;  ///< Address of the lock.
+  const void* site;  ///< Acquire site.
+  uint64_t since;    ///< Timestamp of the acquisition.
+};
+
+struct alignas(CACHE_LINE_SIZE) HeldStack {
+  HeldLock locks[LOCKDEP_MAX_HELD];
+  size_t depth;  ///< Number of locks held, may exceed `LOCKDEP_MAX_HELD`.
+};
+
+/**
+ * @brief A lock order that was observed: `second` was acquired while holding `first`.
+ */
+struct LockOrder {
+  const void* first;
+  const void* second;
+};
+
+HeldStack held[MAX_CPUS];
+
+LockOrder orders[LOCKDEP_MAX_ORDERS];
+size_t order_count = 0;
+TicketLock orders_lock;  ///< Taken directly, a guard would report to the validator itself.
+
+size_t hash(const void* first, const void* second) {
+  const auto a = reinterpret_cast<uintptr_t>(first);
+  const auto b = reinterpret_cast<uintptr_t>(second);
+
+  return ((a * 0x9e3779b97f4a7c15ull) ^ (b * 0xc2b2ae3d27d4eb4full)) >> 32;
+}
+
+LockOrder* find_order(const void* first, const void* second) {
+  const size_t mask = LOCKDEP_MAX_ORDERS - 1;
+
+  for (size_t idx = hash(first, second) & mask; orders[idx].first; idx = (idx + 1) & mask) {
+    if (orders[idx].first == first && orders[idx].second == second) {
+      return &orders[idx];
+    }
+  }
+
+  return nullptr;
+}
+
+void insert_order(const void* first, const void* second) {
+  const size_t mask = LOCKDEP_MAX_ORDERS - 1;
+
+  if (order_count == LOCKDEP_MAX_ORDERS / 4 * 3) {
+    return;
+  }
+
+  size_t idx = hash(first, second) & mask;
+
+  while (orders[idx].first) {
+    if (orders[idx].first == first && orders[idx].second == second) {
+      return;
+    }
+
+    idx = (idx + 1) & mask;
+  }
+
+  orders[idx] = {first, second};
+  order_count++;
+}
+}  // namespace
+
+/**
+ * @details Checks the new lock against every lock the processor holds. An inversion is reported
+ * every time it happens, the order table itself only grows until it is three quarters full.
+ */
+void lockdep_check(const void* lock, const void* site) {
+  const uint64_t flags = arch_interrupt_save();
+  const HeldStack& stack = held[arch_cpu_index()];
+  const size_t depth = std::min(stack.depth, static_cast<size_t>(LOCKDEP_MAX_HELD));
+
+  for (size_t i = 0; i < depth; i++) {
+    if (stack.locks[i].lock == lock) {
+      log_panic("Recursive acquisition of lock %p at %p, already acquired at %p", lock, site,
+                stack.locks[i].site);
+    }
+  }
+
+  orders_lock.lock();
+
+  for (size_t i = 0; i < depth; i++) {
+    const HeldLock& outer = stack.locks[i];
+
+    if (find_order(lock, outer.lock)) {
+      log_warn("Lock order inversion: %p acquired at %p while holding %p acquired at %p", lock,
+               site, outer.lock, outer.site);
+    }
+
+    insert_order(outer.lock, lock);
+  }
+
+  orders_lock.unlock();
+  arch_interrupt_restore(flags);
+}
+
+void lockdep_acquire(const void* lock, const void* site) {
+  const uint64_t flags = arch_interrupt_save();
+  HeldStack& stack = held[arch_cpu_index()];
+
+  if (stack.depth < LOCKDEP_MAX_HELD) {
+    stack.locks[stack.depth] = {lock, site, rdtsc()};
+  }
+
+  stack.depth++;
+  arch_interrupt_restore(flags);
+}
+
+/**
+ * @details Locks are usually released in the reverse order of their acquisition, so the search
+ * starts at the top of the stack.
+ */
+void lockdep_release(const void* lock) {
+  const uint64_t flags = arch_interrupt_save();
+  HeldStack& stack = held[arch_cpu_index()];
+  const size_t depth = std::min(stack.depth, static_cast<size_t>(LOCKDEP_MAX_HELD));
+
+  for (size_t i = depth; i-- > 0;) {
+    if (stack.locks[i].lock != lock) {
+      continue;
+    }
+
+    const uint64_t cycles = rdtsc() - stack.locks[i].since;
+
+    if (cycles > LOCKDEP_HOLD_LIMIT_CYCLES) {
+      log_warn("Lock %p held for %lu cycles, acquired at %p", lock, cycles,
+               stack.locks[i].site);
+    }
+
+    for (size_t j = i; j + 1 < depth; j++) {
+      stack.locks[j] = stack.locks[j + 1];
+    }
+
+    break;
+  }
+
+  if (stack.depth) {
+    stack.depth--;
+  }
+
+  arch_interrupt_restore(flags);
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include <log.hpp>
+
+#include <algorithm>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/sync/lockstat.hpp>
+#include <lock.hpp>
+
+/**
+ * @brief Classes kept per processor at most, leaving a quarter of the table free to keep probe
+ * sequences short.
+ */
+#define LOCKSTAT_MAX_CLASSES (LOCKSTAT_CLASSES / 4 * 3)
+
+/**
+ * @brief Statistics of one lock class on one processor.
+ */
+struct LockClassStat {
+  const void* site;       ///< Acquire site of the lock, `nullptr` if the slot is unused.
+  uint64_t acquisitions;  ///< Acquisitions so far.
+  uint64_t contended;     ///< Acquisitions that had to wait.
+  uint64_t wait_total;    ///< Cycles spent waiting in all contended acquisitions.
+  uint64_t wait_max;      ///< Longest wait in cycles.
+  uint64_t hold_max;      ///< Longest hold time in cycles.
+};
+
+namespace {
+/**
+ * @brief Lock classes seen by one processor, only written by that processor.
+ */
+struct alignas(CACHE_LINE_SIZE) ClassTable {
+  LockClassStat classes[LOCKSTAT_CLASSES];
+  size_t count;    ///< Number of used slots in `classes`.
+  size_t dropped;  ///< Acquisitions not recorded because the table was full.
+};
+
+ClassTable tables[MAX_CPUS];
+LockClassStat merged[LOCKSTAT_CLASSES];  ///< Scratch space of `lockstat_dump`.
+uint16_t order[LOCKSTAT_CLASSES];        ///< Scratch space of `lockstat_dump`.
+TicketLock dump_lock;                    ///< Serializes users of the scratch space.
+
+size_t hash(const void* site) {
+  return (reinterpret_cast<uintptr_t>(site) * 0x9e3779b97f4a7c15ull) >> 32;
+}
+
+/**
+ * @brief Finds the slot of `site` in `classes`, claiming a free one if `count` allows.
+ */
+LockClassStat* find_class(LockClassStat* classes, size_t& count, const void* site) {
+  const size_t mask = LOCKSTAT_CLASSES - 1;
+
+  for (size_t idx = hash(site) & mask;; idx = (idx + 1) & mask) {
+    LockClassStat& stat = classes[idx];
+
+    if (stat.site == site) {
+      return &stat;
+    }
+
+    if (!stat.site) {
+      if (count == LOCKSTAT_MAX_CLASSES) {
+        return nullptr;
+      }
+
+      stat = {site, 0, 0, 0, 0, 0};
+      count++;
+      return &stat;
+    }
+  }
+}
+
+/**
+ * @details Sums up the counters of a class over all processors and keeps the largest maxima.
+ * Other processors keep recording meanwhile, so the result is a slightly inconsistent snapshot.
+ * @return Number of acquisitions that are missing from the result.
+ */
+size_t merge_tables() {
+  size_t count = 0;
+  size_t dropped = 0;
+
+  for (auto& stat : merged) {
+    stat = {};
+  }
+
+  for (uint32_t cpu = 0; cpu < cpu_count(); cpu++) {
+    const ClassTable& table = tables[cpu];
+    dropped += table.dropped;
+
+    for (const auto& stat : table.classes) {
+      if (!stat.site) {
+        continue;
+      }
+
+      LockClassStat* total = find_class(merged, count, stat.site);
+
+      if (!total) {
+        dropped += stat.acquisitions;
+        continue;
+      }
+
+      total->acquisitions += stat.acquisitions;
+      total->contended += stat.contended;
+      total->wait_total += stat.wait_total;
+      total->wait_max = std::max(total->wait_max, stat.wait_max);
+      total->hold_max = std::max(total->hold_max, stat.hold_max);
+    }
+  }
+
+  return dropped;
+}
+}  // namespace
+
+void lockstat_acquired(LockStatSample& sample, const void* site, uint64_t start, bool contended) {
+  const uint64_t flags = arch_interrupt_save();
+  ClassTable& table = tables[arch_cpu_index()];
+  LockClassStat* stat = find_class(table.classes, table.count, site);
+  const uint64_t now = rdtsc();
+
+  if (stat) {
+    stat->acquisitions++;
+
+    if (contended) {
+      const uint64_t wait = now - start;
+
+      stat->contended++;
+      stat->wait_total += wait;
+      stat->wait_max = std::max(stat->wait_max, wait);
+    }
+  } else {
+    table.dropped++;
+  }
+
+  arch_interrupt_restore(flags);
+  sample = {stat, now};
+}
+
+/**
+ * @details Interrupts are disabled so a handler releasing a lock of the same class cannot
+ * interleave with the update of the maximum.
+ */
+void lockstat_released(const LockStatSample& sample) {
+  if (!sample.stat) {
+    return;
+  }
+
+  const uint64_t flags = arch_interrupt_save();
+  const uint64_t hold = rdtsc() - sample.acquired;
+
+  sample.stat->hold_max = std::max(sample.stat->hold_max, hold);
+  arch_interrupt_restore(flags);
+}
+
+/**
+ * @details Selects the `top` classes with a partial selection sort over an index array, so the
+ * dump works without allocating.
+ */
+void lockstat_dump(size_t top) {
+  LockGuard guard(dump_lock);
+
+  const size_t dropped = merge_tables();
+
+  size_t count = 0;
+
+  for (size_t i = 0; i < LOCKSTAT_CLASSES; i++) {
+    if (merged[i].site) {
+      order[count++] = static_cast<uint16_t>(i);
+    }
+  }
+
+  top = std::min(top, count);
+  log_info("Top %lu lock acquire sites by total wait:", top);
+
+  for (size_t i = 0; i < top; i++) {
+    for (size_t j = i + 1; j < count; j++) {
+      if (merged[order[j]].wait_total > merged[order[i]].wait_total) {
+        std::swap(order[i], order[j]);
+      }
+    }
+
+    const LockClassStat& stat = merged[order[i]];
+    const uint64_t wait_avg = stat.contended ? stat.wait_total / stat.contended : 0;
+
+    log_info("  site %p acquired: %lu contended: %lu wait total: %lu avg: %lu max: %lu "
+             "hold max: %lu cycles",
+             stat.site, stat.acquisitions, stat.contended, stat.wait_total, wait_avg,
+             stat.wait_max, stat.hold_max);
+  }
+
+  if (dropped) {
+    log_warn("Lock statistics dropped %lu acquisitions, the tables are full.", dropped);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include <kernel/arch/arch.hpp>
+#include <kernel/sync/qspinlock.hpp>
+
+namespace {
+McsNode nodes[MAX_CPUS][QSPINLOCK_MAX_NESTING];
+
+uint16_t encode_tail(uint32_t cpu, uint32_t index) {
+  return static_cast<uint16_t>(((cpu + 1) << QSPINLOCK_TAIL_INDEX_BITS) | index);
+}
+
+McsNode* decode_tail(uint16_t tail) {
+  const uint32_t cpu = (tail >> QSPINLOCK_TAIL_INDEX_BITS) - 1;
+  const uint32_t index = tail & ((1u << QSPINLOCK_TAIL_INDEX_BITS) - 1);
+
+  return &nodes[cpu][index];
+}
+}  // namespace
+
+/**
+ * @details The processor takes the next free node of its own, publishes it as the new tail and
+ * links it behind the previous tail, then spins on its own node until the predecessor hands over.
+ * As head of the queue it waits for the holder to release the locked byte. If no one queued behind
+ * it, the lock is taken and the tail cleared in one step; otherwise it sets the locked byte and
+ * wakes its successor, which becomes the new head.
+ */
+void QueuedSpinLock::lock_slow() {
+  const uint32_t cpu = arch_cpu_index();
+  McsNode* first = &nodes[cpu][0];
+  const uint32_t index = first->count++;
+
+  // Interrupts nested deeper than the node supply wait on the lock word instead.
+  if (unlikely(index >= QSPINLOCK_MAX_NESTING)) {
+    while (!this->try_lock()) {
+      arch_pause();
+    }
+
+    first->count--;
+    return;
+  }
+
+  McsNode* node = &nodes[cpu][index];
+  node->next = nullptr;
+  node->ready = 0;
+
+  // An interrupt arriving from here on must see the node as taken.
+  asm volatile("" ::: "memory");
+
+  if (!this->try_lock()) {
+    const uint16_t tail = encode_tail(cpu, index);
+    const uint16_t previous = __atomic_exchange_n(&this->m_word.parts.tail, tail, __ATOMIC_ACQ_REL);
+
+    if (previous) {
+      __atomic_store_n(&decode_tail(previous)->next, node, __ATOMIC_RELEASE);
+
+      while (!__atomic_load_n(&node->ready, __ATOMIC_ACQUIRE)) {
+        arch_pause();
+      }
+    }
+
+    uint32_t value;
+
+    while ((value = __atomic_load_n(&this->m_word.value, __ATOMIC_ACQUIRE)) &
+           QSPINLOCK_LOCKED_MASK) {
+      arch_pause();
+    }
+
+    const bool last = (value >> QSPINLOCK_TAIL_SHIFT) == tail &&
+                      __atomic_compare_exchange_n(&this->m_word.value, &value, QSPINLOCK_LOCKED,
+                                                  false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+
+    if (!last) {
+      // The tail belongs to a successor, so the fast path cannot take the lock meanwhile.
+      __atomic_store_n(&this->m_word.parts.locked, QSPINLOCK_LOCKED, __ATOMIC_RELAXED);
+
+      McsNode* next;
+
+      while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))) {
+        arch_pause();
+      }
+
+      __atomic_store_n(&next->ready, 1, __ATOMIC_RELEASE);
+    }
+  }
+
+  first->count--;
+}
\ No newline at end of file
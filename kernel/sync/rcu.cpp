@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <atomic>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/percpu.hpp>
+#include <kernel/sync/qspinlock.hpp>
+#include <kernel/sync/rcu.hpp>
+
+static_assert(MAX_CPUS <= 64, "The pending mask has one bit per processor");
+
+namespace {
+/**
+ * @brief Grace period state shared by all processors.
+ *
+ * @details Grace periods are numbered. One is in progress while `started` is ahead of `completed`,
+ * and it ends when the last processor in `pending` reported a quiescent state.
+ */
+struct RcuState {
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> pending;  ///< Processors yet to report.
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> completed;
+
+  uint64_t started;    ///< Protected by `lock`.
+  uint64_t requested;  ///< Highest grace period anyone waits for, protected by `lock`.
+  QueuedSpinLock lock;
+};
+
+/**
+ * @brief Per-CPU callback lists, only touched by their processor with interrupts disabled.
+ */
+struct alignas(CACHE_LINE_SIZE) RcuCpu {
+  RcuHead* next_head;   ///< Callbacks not yet assigned to a grace period.
+  RcuHead* next_tail;   ///< Last entry of `next_head`.
+  RcuHead* wait_head;   ///< Callbacks waiting for grace period `wait_for`.
+  uint64_t wait_for;    ///< Grace period the callbacks in `wait_head` wait for.
+  std::atomic<bool> idle;  ///< Set while the processor is in the extended quiescent state.
+};
+
+RcuState state;
+RcuCpu rcu_cpus[MAX_CPUS];
+
+/**
+ * @details Starts grace periods until one has processors to wait for or all requests are served.
+ * Halted processors are left out, their next read section starts after the grace period did.
+ */
+void advance_locked() {
+  while (state.requested > state.completed.load(std::memory_order_relaxed)) {
+    uint64_t mask = 0;
+
+    for (uint32_t i = 0; i < cpu_count(); i++) {
+      if (cpu_data(i)->online.load(std::memory_order_acquire) &&
+          !rcu_cpus[i].idle.load(std::memory_order_seq_cst)) {
+        mask |= 1ul << i;
+      }
+    }
+
+    state.started++;
+
+    if (mask) {
+      state.pending.store(mask, std::memory_order_seq_cst);
+      return;
+    }
+
+    state.completed.store(state.started, std::memory_order_release);
+  }
+}
+
+/**
+ * @brief Requests a grace period that starts after the call.
+ * @return Number of the grace period to wait for.
+ */
+uint64_t request_grace_period() {
+  const uint64_t flags = arch_interrupt_save();
+  state.lock.lock();
+
+  // A grace period in progress may have started before the caller's update, so wait for the next.
+  const uint64_t target = state.started + 1;
+  state.requested = std::max(state.requested, target);
+
+  if (state.started == state.completed.load(std::memory_order_relaxed)) {
+    advance_locked();
+  }
+
+  state.lock.unlock();
+  arch_interrupt_restore(flags);
+
+  return target;
+}
+
+void report(uint32_t cpu) {
+  const uint64_t bit = 1ul << cpu;
+
+  if (!(state.pending.load(std::memory_order_seq_cst) & bit)) {
+    return;
+  }
+
+  if (state.pending.fetch_and(~bit, std::memory_order_acq_rel) == bit) {
+    state.lock.lock();
+    state.completed.store(state.started, std::memory_order_release);
+    advance_locked();
+    state.lock.unlock();
+  }
+}
+
+/**
+ * @details Moves the waiting batch to the caller once its grace period completed, and assigns the
+ * callbacks queued since to a new grace period.
+ */
+RcuHead* collect_expired(RcuCpu& rcu) {
+  RcuHead* expired = nullptr;
+
+  if (rcu.wait_head && state.completed.load(std::memory_order_acquire) >= rcu.wait_for) {
+    expired = rcu.wait_head;
+    rcu.wait_head = nullptr;
+  }
+
+  if (!rcu.wait_head && rcu.next_head) {
+    rcu.wait_head = rcu.next_head;
+    rcu.next_head = nullptr;
+    rcu.next_tail = nullptr;
+    rcu.wait_for = request_grace_period();
+  }
+
+  return expired;
+}
+
+void run_callbacks(RcuHead* head) {
+  while (head) {
+    RcuHead* next = head->next;
+    head->callback(head);
+    head = next;
+  }
+}
+}  // namespace
+
+void synchronize_rcu() {
+  const uint64_t target = request_grace_period();
+
+  while (state.completed.load(std::memory_order_acquire) < target) {
+    rcu_quiescent();
+    arch_pause();
+  }
+}
+
+void call_rcu(RcuHead* head, RcuCallback callback) {
+  head->next = nullptr;
+  head->callback = callback;
+
+  const uint64_t flags = arch_interrupt_save();
+  RcuCpu& rcu = rcu_cpus[arch_cpu_index()];
+
+  if (rcu.next_tail) {
+    rcu.next_tail->next = head;
+  } else {
+    rcu.next_head = head;
+  }
+
+  rcu.next_tail = head;
+  arch_interrupt_restore(flags);
+}
+
+/**
+ * @details Expired callbacks run after interrupts were restored, so long batches do not add to
+ * interrupt latency.
+ */
+void rcu_quiescent() {
+  const uint64_t flags = arch_interrupt_save();
+  const uint32_t cpu = arch_cpu_index();
+
+  report(cpu);
+  RcuHead* expired = collect_expired(rcu_cpus[cpu]);
+
+  arch_interrupt_restore(flags);
+  run_callbacks(expired);
+}
+
+/**
+ * @details A grace period that started before the flag became visible may still count on this
+ * processor, so it reports once more afterwards.
+ */
+void rcu_idle_enter() {
+  rcu_quiescent();
+
+  const uint64_t flags = arch_interrupt_save();
+  const uint32_t cpu = arch_cpu_index();
+
+  rcu_cpus[cpu].idle.store(true, std::memory_order_seq_cst);
+  report(cpu);
+
+  arch_interrupt_restore(flags);
+}
+
+void rcu_idle_exit() {
+  rcu_cpus[arch_cpu_index()].idle.store(false, std::memory_order_seq_cst);
+}
+
+/**
+ * @details Clearing the flag is ordered before the reads of the interrupt like in `rcu_idle_exit`,
+ * so a grace period that left this processor out started before any of them.
+ */
+bool rcu_irq_enter() {
+  RcuCpu& rcu = rcu_cpus[arch_cpu_index()];
+
+  if (!rcu.idle.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  rcu.idle.store(false, std::memory_order_seq_cst);
+  return true;
+}
+
+/**
+ * @details A grace period that started while the interrupt ran counts on this processor, which is
+ * quiescent now, so it reports like `rcu_idle_enter`.
+ */
+void rcu_irq_exit(bool idle) {
+  if (!idle) {
+    return;
+  }
+
+  const uint32_t cpu = arch_cpu_index();
+
+  rcu_cpus[cpu].idle.store(true, std::memory_order_seq_cst);
+  report(cpu);
+}
\ No newline at end of file
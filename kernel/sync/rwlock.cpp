@@ -0,0 +1,120 @@
+#include <kernel/sync/rwlock.hpp>
+
+/**
+ * @details Backs out of the optimistic increment and waits until no writer holds or waits for the
+ * lock before trying again.
+ */
+void RwSpinLock::read_lock_slow() {
+  while (true) {
+    this->m_state.fetch_sub(RWLOCK_READER, std::memory_order_relaxed);
+
+    while (this->m_state.load(std::memory_order_relaxed) &
+           (RWLOCK_WRITER_LOCKED | RWLOCK_WRITER_WAITING)) {
+      arch_pause();
+    }
+
+    const uint32_t state = this->m_state.fetch_add(RWLOCK_READER, std::memory_order_acquire);
+
+    if (!(state & (RWLOCK_WRITER_LOCKED | RWLOCK_WRITER_WAITING))) {
+      return;
+    }
+  }
+}
+
+/**
+ * @details Sets the waiting flag to hold back new readers, then waits for the active readers and
+ * writer to leave. The flag is cleared when the lock is taken; other waiting writers set it again
+ * on their next iteration.
+ */
+void RwSpinLock::write_lock_slow() {
+  while (true) {
+    uint32_t state = this->m_state.load(std::memory_order_relaxed);
+
+    if ((state & ~RWLOCK_WRITER_WAITING) == 0) {
+      if (this->m_state.compare_exchange_weak(state, RWLOCK_WRITER_LOCKED,
+                                              std::memory_order_acquire,
+                                              std::memory_order_relaxed)) {
+        return;
+      }
+
+      continue;
+    }
+
+    if (!(state & RWLOCK_WRITER_WAITING)) {
+      this->m_state.fetch_or(RWLOCK_WRITER_WAITING, std::memory_order_relaxed);
+    }
+
+    arch_pause();
+  }
+}
+
+void PercpuRwLock::read_lock_slow() {
+  std::atomic<int32_t>& count = this->m_readers[arch_cpu_index()].count;
+
+  while (true) {
+    while (this->m_writer.load(std::memory_order_relaxed)) {
+      arch_pause();
+    }
+
+    count.fetch_add(1, std::memory_order_seq_cst);
+
+    if (!this->m_writer.load(std::memory_order_seq_cst)) {
+      return;
+    }
+
+    count.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @details Readers that started before the flag was raised are counted in the sum, readers that
+ * start afterwards see the flag and back off.
+ */
+void PercpuRwLock::write_lock() {
+  this->m_writer_lock.lock();
+  this->m_writer.store(true, std::memory_order_seq_cst);
+
+  while (true) {
+    int32_t readers = 0;
+
+    for (const auto& slot : this->m_readers) {
+      readers += slot.count.load(std::memory_order_acquire);
+    }
+
+    if (readers == 0) {
+      return;
+    }
+
+    arch_pause();
+  }
+}
+
+/**
+ * @details Raises the flag like `write_lock`, but lowers it again instead of waiting if a reader
+ * is active.
+ */
+bool PercpuRwLock::try_write_lock() {
+  if (!this->m_writer_lock.try_lock()) {
+    return false;
+  }
+
+  this->m_writer.store(true, std::memory_order_seq_cst);
+
+  int32_t readers = 0;
+
+  for (const auto& slot : this->m_readers) {
+    readers += slot.count.load(std::memory_order_acquire);
+  }
+
+  if (readers == 0) {
+    return true;
+  }
+
+  this->write_unlock();
+  return false;
+}
+
+void PercpuRwLock::write_unlock() {
+  this->m_writer.store(false, std::memory_order_release);
+  this->m_writer_lock.unlock();
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include <log.hpp>
+
+#include <algorithm>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/features.hpp>
+#include <kernel/arch/x86_64/drivers/pit.hpp>
+#include <kernel/time/clock.hpp>
+
+ClockSource clock_source = {};
+
+namespace {
+bool tsc_adjust = false;
+uint64_t boot_adjust = 0;  ///< TSC_ADJUST of the boot processor.
+
+/**
+ * @brief Returns the TSC frequency reported by CPUID, 0 if unknown.
+ *
+ * @details Leaf 0x15 gives the ratio of TSC to crystal clock and, on newer processors, the
+ * crystal frequency. Where the crystal frequency is missing, the base frequency of leaf 0x16 is
+ * used, which the TSC runs at on those processors.
+ */
+uint64_t cpuid_frequency() {
+  CpuidLeaf leaf = {};
+
+  if (read_cpuid(&leaf, CPUID_TSC, 0) && leaf.values[0] && leaf.values[1] && leaf.values[2]) {
+    return static_cast<uint64_t>(leaf.values[2]) * leaf.values[1] / leaf.values[0];
+  }
+
+  if (read_cpuid(&leaf, CPUID_FREQUENCY, 0) && (leaf.values[0] & 0xffff)) {
+    return (leaf.values[0] & 0xffff) * 1000000ul;
+  }
+
+  return 0;
+}
+
+/**
+ * @details Interrupts and SMIs during a run only make it longer, so the shortest run is closest to
+ * the real frequency.
+ */
+uint64_t pit_frequency() {
+  uint64_t cycles = UINT64_MAX;
+  const uint64_t flags = arch_interrupt_save();
+
+  for (size_t i = 0; i < CLOCK_CALIBRATION_RUNS; i++) {
+    cycles = std::min(cycles, pit_measure_tsc(CLOCK_CALIBRATION_MS));
+  }
+
+  arch_interrupt_restore(flags);
+  return cycles * 1000 / CLOCK_CALIBRATION_MS;
+}
+
+/// @brief Returns `(a << CLOCK_SHIFT) / b` without overflowing the shift.
+uint64_t scaled_ratio(uint64_t a, uint64_t b) {
+  return ((a / b) << CLOCK_SHIFT) + ((a % b) << CLOCK_SHIFT) / b;
+}
+}  // namespace
+
+void clock_initialize() {
+  uint64_t frequency = cpuid_frequency();
+  const char* source = "CPUID";
+
+  if (!frequency) {
+    frequency = pit_frequency();
+    source = "PIT";
+  }
+
+  if (!test_feature(FEATURE_INVARIANT_TSC)) {
+    log_warn("TSC is not invariant, its rate may change with power states.");
+  }
+
+  tsc_adjust = test_feature(FEATURE_TSC_ADJUST);
+  boot_adjust = tsc_adjust ? read_msr(MSR_TSC_ADJUST) : 0;
+
+  clock_source.frequency = frequency;
+  clock_source.mult = scaled_ratio(NS_PER_SECOND, frequency);
+  clock_source.inverse_mult = scaled_ratio(frequency, NS_PER_SECOND);
+  clock_source.base = rdtsc();
+
+  log_info("TSC runs at %lu kHz (%s).", frequency / 1000, source);
+}
+
+void clock_sync() {
+  if (!tsc_adjust) {
+    return;
+  }
+
+  const uint64_t adjust = read_msr(MSR_TSC_ADJUST);
+
+  if (adjust != boot_adjust) {
+    log_warn("TSC of processor %u is off by %ld cycles, synchronizing.", arch_cpu_index(),
+             static_cast<int64_t>(adjust - boot_adjust));
+    write_msr(MSR_TSC_ADJUST, boot_adjust);
+  }
+}
\ No newline at end of file
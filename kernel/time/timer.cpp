@@ -0,0 +1,237 @@
+#include <log.hpp>
+
+#include <utility>
+
+#include <kernel/arch/arch.hpp>
+#include <kernel/arch/x86_64/cpu/cpu.hpp>
+#include <kernel/arch/x86_64/cpu/interrupt.hpp>
+#include <kernel/arch/x86_64/cpu/lapic.hpp>
+#include <kernel/irq/softirq.hpp>
+#include <kernel/sync/irq.hpp>
+#include <kernel/sync/qspinlock.hpp>
+#include <kernel/time/timer.hpp>
+
+namespace {
+/**
+ * @brief Pending timers of one processor.
+ *
+ * @details The queue is only changed by its processor, except for cancellations. `armed` is the
+ * deadline the hardware was last programmed with, 0 while it is disarmed.
+ */
+struct alignas(CACHE_LINE_SIZE) TimerQueue {
+  QueuedSpinLock lock;
+  uint32_t count;
+  uint64_t armed;
+  Timer* heap[TIMER_QUEUE_CAPACITY];
+};
+
+TimerQueue queues[MAX_CPUS];
+
+void place(TimerQueue& queue, Timer* timer, uint32_t index) {
+  queue.heap[index] = timer;
+  timer->index = index;
+}
+
+void sift_up(TimerQueue& queue, uint32_t index) {
+  Timer* timer = queue.heap[index];
+
+  while (index > 0) {
+    const uint32_t parent = (index - 1) / 2;
+
+    if (queue.heap[parent]->deadline <= timer->deadline) {
+      break;
+    }
+
+    place(queue, queue.heap[parent], index);
+    index = parent;
+  }
+
+  place(queue, timer, index);
+}
+
+void sift_down(TimerQueue& queue, uint32_t index) {
+  Timer* timer = queue.heap[index];
+
+  while (true) {
+    uint32_t child = 2 * index + 1;
+
+    if (child >= queue.count) {
+      break;
+    }
+
+    if (child + 1 < queue.count && queue.heap[child + 1]->deadline < queue.heap[child]->deadline) {
+      child++;
+    }
+
+    if (timer->deadline <= queue.heap[child]->deadline) {
+      break;
+    }
+
+    place(queue, queue.heap[child], index);
+    index = child;
+  }
+
+  place(queue, timer, index);
+}
+
+/**
+ * @details The last entry takes the place of the removed one and moves up or down from there.
+ */
+void remove(TimerQueue& queue, Timer* timer) {
+  const uint32_t index = std::exchange(timer->index, TIMER_INACTIVE);
+  Timer* last = queue.heap[--queue.count];
+
+  if (index == queue.count) {
+    return;
+  }
+
+  place(queue, last, index);
+  sift_up(queue, index);
+  sift_down(queue, last->index);
+}
+
+/**
+ * @brief Programs the hardware for the earliest deadline of the executing processor's queue.
+ * @details Nothing is written if the hardware already waits for that deadline.
+ */
+void rearm(TimerQueue& queue) {
+  const uint64_t deadline = queue.count ? queue.heap[0]->deadline : 0;
+
+  if (deadline == queue.armed) {
+    return;
+  }
+
+  queue.armed = deadline;
+
+  if (deadline) {
+    lapic_timer_arm(deadline);
+  } else {
+    lapic_timer_disarm();
+  }
+}
+
+/**
+ * @details The hardware disarmed itself when it fired, expired timers run in the software
+ * interrupt.
+ */
+void timer_handler(Iframe*, void*) {
+  TimerQueue& queue = queues[arch_cpu_index()];
+
+  lapic_eoi();
+  queue.lock.lock();
+  queue.armed = 0;
+  queue.lock.unlock();
+
+  softirq_raise(SOFTIRQ_TIMER);
+}
+
+/**
+ * @details The lock is dropped while a callback runs, so callbacks can restart or cancel timers.
+ * A run that finds no expired timer, e.g. after a cancellation or an early fire of the calibrated
+ * one-shot timer, only re-arms.
+ */
+void timer_softirq() {
+  TimerQueue& queue = queues[arch_cpu_index()];
+  uint64_t flags = arch_interrupt_save();
+
+  queue.lock.lock();
+
+  while (queue.count && queue.heap[0]->deadline <= rdtsc()) {
+    Timer* timer = queue.heap[0];
+    remove(queue, timer);
+
+    queue.lock.unlock();
+    arch_interrupt_restore(flags);
+
+    timer->callback(timer);
+
+    flags = arch_interrupt_save();
+    queue.lock.lock();
+  }
+
+  rearm(queue);
+  queue.lock.unlock();
+  arch_interrupt_restore(flags);
+}
+}  // namespace
+
+void timer_initialize() {
+  softirq_register(SOFTIRQ_TIMER, timer_softirq);
+  interrupt_register(INTERRUPT_APIC_TIMER, timer_handler);
+}
+
+/**
+ * @details A deadline of 0 would read as disarmed, so it is moved to 1 which has passed as well.
+ */
+bool timer_start(Timer* timer, uint64_t deadline) {
+  const uint64_t flags = arch_interrupt_save();
+  timer_cancel(timer);
+
+  const uint32_t cpu = arch_cpu_index();
+  TimerQueue& queue = queues[cpu];
+  bool started = false;
+
+  queue.lock.lock();
+
+  if (queue.count < TIMER_QUEUE_CAPACITY) {
+    timer->deadline = deadline ? deadline : 1;
+    timer->cpu.store(cpu, std::memory_order_relaxed);
+    place(queue, timer, queue.count++);
+    sift_up(queue, timer->index);
+    rearm(queue);
+    started = true;
+  }
+
+  queue.lock.unlock();
+  arch_interrupt_restore(flags);
+
+  if (!started) {
+    log_warn("Timer queue of processor %u is full.", cpu);
+  }
+
+  return started;
+}
+
+/**
+ * @details The owner is looked up again under its lock because a concurrent restart may have moved
+ * the timer to another queue. A remote processor cannot program the owner's hardware, so the
+ * owner may still take an interrupt for the cancelled deadline; it finds nothing expired and
+ * re-arms.
+ */
+bool timer_cancel(Timer* timer) {
+  while (true) {
+    const uint32_t cpu = timer->cpu.load(std::memory_order_relaxed);
+    TimerQueue& queue = queues[cpu];
+    IrqSpinGuard guard(queue.lock);
+
+    if (timer->cpu.load(std::memory_order_relaxed) != cpu) {
+      continue;
+    }
+
+    if (timer->index == TIMER_INACTIVE) {
+      return false;
+    }
+
+    remove(queue, timer);
+
+    if (cpu == arch_cpu_index()) {
+      rearm(queue);
+    }
+
+    return true;
+  }
+}
+
+bool timer_pending(const Timer* timer) {
+  TimerQueue& queue = queues[timer->cpu.load(std::memory_order_relaxed)];
+  IrqSpinGuard guard(queue.lock);
+
+  return timer->index != TIMER_INACTIVE;
+}
+
+/**
+ * @details Reads the deadline the hardware is armed for without the lock, the result is a hint.
+ */
+uint64_t timer_next_deadline() {
+  return __atomic_load_n(&queues[arch_cpu_index()].armed, __ATOMIC_RELAXED);
+}
\ No newline at end of file